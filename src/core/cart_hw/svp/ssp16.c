@@ -1085,6 +1085,8 @@ static void debug(unsigned int pc, unsigned int op)
 
 void ssp1601_run(int cycles)
 {
+  PROFILER_ENTER(PROF_SVP);
+
   SET_PC(rPC);
   g_cycles = cycles;
 
@@ -1326,5 +1328,7 @@ void ssp1601_run(int cycles)
   if (ssp->gr[SSP_GR0].v != 0xffff0000)
     elprintf(EL_ANOMALY|EL_SVP, "ssp FIXME: REG 0 corruption! %08x", ssp->gr[SSP_GR0].v);
 #endif
+
+  PROFILER_LEAVE();
 }
 
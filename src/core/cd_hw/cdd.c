@@ -35,9 +35,33 @@
  *  POSSIBILITY OF SUCH DAMAGE.
  *
  ****************************************************************************************/
+#if defined(USE_CD_MMAP) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "shared.h"
 #include "megasd.h"
 
+#if defined(USE_OGG_THREAD) && !defined(USE_LIBTREMOR) && !defined(USE_LIBVORBIS)
+#undef USE_OGG_THREAD
+#endif
+
+#if defined(USE_CHD_THREAD) || defined(USE_OGG_THREAD) || defined(USE_CD_CACHE)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#ifdef USE_CD_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef USE_CD_CACHE
+#include <time.h>
+#endif
+
 extern int8 audio_hard_disable;
 
 #if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
@@ -54,6 +78,300 @@ extern int8 audio_hard_disable;
 #define TYPE_MODE1 0x01
 #define TYPE_MODE2 0x02
 
+/* number of CD-DA samples mixed at once */
+#define CDD_MIX_SIZE 512
+
+#if defined(USE_LIBCHDR)
+/* number of CHD hunks prefetched ahead of CD drive head */
+#define CHD_PREFETCH 4
+
+#ifdef USE_CHD_THREAD
+/* CHD hunks are decompressed ahead of CD drive head by a worker thread */
+static struct
+{
+  pthread_t thread;
+  pthread_mutex_t mutex;    /* protects hunks cache & requests */
+  pthread_mutex_t decoder;  /* serializes chd_read() calls */
+  pthread_cond_t request;
+  pthread_cond_t loaded;
+  int started;
+  int disabled;
+  int quit;
+  int pending;
+  int hunknum;              /* first hunk to prefetch */
+  int loading[CHD_CACHE_SIZE];
+} chd_thread;
+
+#define CHD_LOCK() do { if (chd_thread.started) pthread_mutex_lock(&chd_thread.mutex); } while (0)
+#define CHD_UNLOCK() do { if (chd_thread.started) pthread_mutex_unlock(&chd_thread.mutex); } while (0)
+#else
+#define CHD_LOCK()
+#define CHD_UNLOCK()
+#endif
+
+static int cdd_chd_lookup(int hunknum)
+{
+  int i;
+  for (i=0; i<CHD_CACHE_SIZE; i++)
+  {
+    if (cdd.chd.cachenum[i] == hunknum)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int cdd_chd_victim(void)
+{
+  /* least recently used cache entry, excluding current hunk & hunks being decompressed */
+  int i, slot = -1;
+  for (i=0; i<CHD_CACHE_SIZE; i++)
+  {
+#ifdef USE_CHD_THREAD
+    if (chd_thread.loading[i]) continue;
+#endif
+    if (i == cdd.chd.slot) continue;
+    if (cdd.chd.cachenum[i] < 0) return i;
+    if ((slot < 0) || (cdd.chd.cacheage[i] < cdd.chd.cacheage[slot])) slot = i;
+  }
+  return slot;
+}
+
+static void cdd_chd_decode(int hunknum, int slot)
+{
+#ifdef USE_CHD_THREAD
+  if (chd_thread.started)
+  {
+    chd_thread.loading[slot] = 1;
+    pthread_mutex_unlock(&chd_thread.mutex);
+    pthread_mutex_lock(&chd_thread.decoder);
+    chd_read(cdd.chd.file, hunknum, cdd.chd.cache + slot * cdd.chd.hunkbytes);
+    pthread_mutex_unlock(&chd_thread.decoder);
+    pthread_mutex_lock(&chd_thread.mutex);
+    chd_thread.loading[slot] = 0;
+    pthread_cond_broadcast(&chd_thread.loaded);
+    return;
+  }
+#endif
+  chd_read(cdd.chd.file, hunknum, cdd.chd.cache + slot * cdd.chd.hunkbytes);
+}
+
+#ifdef USE_CHD_THREAD
+static void *cdd_chd_thread_main(void *arg)
+{
+  pthread_mutex_lock(&chd_thread.mutex);
+
+  while (1)
+  {
+    int i, hunknum;
+
+    /* wait for prefetch request */
+    while (!chd_thread.pending && !chd_thread.quit)
+    {
+      pthread_cond_wait(&chd_thread.request, &chd_thread.mutex);
+    }
+
+    if (chd_thread.quit)
+    {
+      pthread_mutex_unlock(&chd_thread.mutex);
+      return NULL;
+    }
+
+    hunknum = chd_thread.hunknum;
+    chd_thread.pending = 0;
+
+    /* decompress upcoming hunks (unless a new request is pending) */
+    for (i=0; (i<CHD_PREFETCH) && (hunknum < cdd.chd.hunks) && !chd_thread.pending && !chd_thread.quit; i++, hunknum++)
+    {
+      int slot;
+
+      if (cdd_chd_lookup(hunknum) >= 0) continue;
+
+      slot = cdd_chd_victim();
+      if (slot < 0) break;
+
+      cdd.chd.cachenum[slot] = hunknum;
+      cdd.chd.cacheage[slot] = ++cdd.chd.age;
+      cdd_chd_decode(hunknum, slot);
+    }
+  }
+}
+
+static void cdd_chd_thread_start(void)
+{
+  /* both threads would compete for the same CPU */
+  if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+  {
+    chd_thread.disabled = 1;
+    return;
+  }
+
+  pthread_mutex_init(&chd_thread.mutex, NULL);
+  pthread_mutex_init(&chd_thread.decoder, NULL);
+  pthread_cond_init(&chd_thread.request, NULL);
+  pthread_cond_init(&chd_thread.loaded, NULL);
+  memset(chd_thread.loading, 0, sizeof(chd_thread.loading));
+  chd_thread.pending = chd_thread.quit = 0;
+  if (pthread_create(&chd_thread.thread, NULL, cdd_chd_thread_main, NULL))
+  {
+    /* fallback to synchronous CHD decompression */
+    pthread_cond_destroy(&chd_thread.loaded);
+    pthread_cond_destroy(&chd_thread.request);
+    pthread_mutex_destroy(&chd_thread.decoder);
+    pthread_mutex_destroy(&chd_thread.mutex);
+    chd_thread.disabled = 1;
+    return;
+  }
+
+  chd_thread.started = 1;
+}
+
+static void cdd_chd_thread_stop(void)
+{
+  if (chd_thread.started)
+  {
+    pthread_mutex_lock(&chd_thread.mutex);
+    chd_thread.quit = 1;
+    pthread_cond_signal(&chd_thread.request);
+    pthread_mutex_unlock(&chd_thread.mutex);
+
+    pthread_join(chd_thread.thread, NULL);
+    pthread_cond_destroy(&chd_thread.loaded);
+    pthread_cond_destroy(&chd_thread.request);
+    pthread_mutex_destroy(&chd_thread.decoder);
+    pthread_mutex_destroy(&chd_thread.mutex);
+    chd_thread.started = 0;
+  }
+
+  chd_thread.disabled = 0;
+}
+#endif
+
+static void cdd_chd_prefetch(int hunknum)
+{
+#ifdef USE_CHD_THREAD
+  if ((hunknum < 0) || (hunknum >= cdd.chd.hunks))
+  {
+    return;
+  }
+
+  if (!chd_thread.started)
+  {
+    if (chd_thread.disabled) return;
+    cdd_chd_thread_start();
+    if (!chd_thread.started) return;
+  }
+
+  /* most recent request replaces any pending one */
+  pthread_mutex_lock(&chd_thread.mutex);
+  chd_thread.hunknum = hunknum;
+  chd_thread.pending = 1;
+  pthread_cond_signal(&chd_thread.request);
+  pthread_mutex_unlock(&chd_thread.mutex);
+#endif
+}
+
+static void cdd_chd_read(int hunknum)
+{
+  int slot;
+
+  CHD_LOCK();
+
+  slot = cdd_chd_lookup(hunknum);
+
+#ifdef USE_CHD_THREAD
+  /* wait until hunk has been decompressed by worker thread */
+  while ((slot >= 0) && chd_thread.loading[slot])
+  {
+    pthread_cond_wait(&chd_thread.loaded, &chd_thread.mutex);
+    slot = cdd_chd_lookup(hunknum);
+  }
+#endif
+
+  /* decompress hunk if not found in cache */
+  if (slot < 0)
+  {
+    cdd.chd.slot = -1;
+    slot = cdd_chd_victim();
+    cdd.chd.cachenum[slot] = hunknum;
+    cdd_chd_decode(hunknum, slot);
+  }
+
+  /* update current hunk */
+  cdd.chd.cacheage[slot] = ++cdd.chd.age;
+  cdd.chd.slot = slot;
+  cdd.chd.hunk = cdd.chd.cache + slot * cdd.chd.hunkbytes;
+  cdd.chd.hunknum = hunknum;
+
+  CHD_UNLOCK();
+
+  /* prefetch next hunks */
+  cdd_chd_prefetch(hunknum + 1);
+}
+
+static void cdd_chd_read_audio(int16 *dst, int count)
+{
+  while (count > 0)
+  {
+#ifdef LSB_FIRST
+    int i;
+#endif
+    int len;
+    uint8 *src;
+
+    /* CHD hunk index */
+    int hunknum = cdd.chd.hunkofs / cdd.chd.hunkbytes;
+
+    /* sector data offset (sectors never cross hunks boundaries) */
+    int pos = cdd.chd.hunkofs % CD_FRAME_SIZE;
+
+    /* update CHD hunk cache if necessary */
+    if (hunknum != cdd.chd.hunknum)
+    {
+      cdd_chd_read(hunknum);
+    }
+
+    /* skip subcode data if needed */
+    if (pos >= CD_MAX_SECTOR_DATA)
+    {
+      cdd.chd.hunkofs += CD_FRAME_SIZE - pos;
+      continue;
+    }
+
+    /* remaining samples in current sector */
+    len = (CD_MAX_SECTOR_DATA - pos) / 4;
+    if (len > count)
+    {
+      len = count;
+    }
+
+    /* copy 16-bit (big-endian) stereo samples */
+    src = cdd.chd.hunk + (cdd.chd.hunkofs % cdd.chd.hunkbytes);
+#ifdef LSB_FIRST
+    for (i=0; i<len*2; i++)
+    {
+      dst[i] = (int16)((src[i*2] << 8) | src[i*2+1]);
+    }
+#else
+    memcpy(dst, src, len * 4);
+#endif
+    dst += len * 2;
+    count -= len;
+
+    /* update CHD file offset */
+    cdd.chd.hunkofs += len * 4;
+
+    /* detect end of sector data (2352 bytes) */
+    if ((cdd.chd.hunkofs % CD_FRAME_SIZE) == CD_MAX_SECTOR_DATA)
+    {
+      /* skip subcode data (96 bytes) */
+      cdd.chd.hunkofs += CD_MAX_SUBCODE_DATA;
+    }
+  }
+}
+#endif
+
 /* BCD conversion lookup tables */
 static const uint8 lut_BCD_8[100] =
 {
@@ -107,88 +425,1549 @@ static const uint32 toc_shadow[15] =
   11637,  2547,  2521,  3856, 900
 };
 
-static const uint32 toc_dungeon[13] =
-{
-  2250, 22950, 16350, 24900, 13875, 19950, 13800, 15375, 17400, 17100,
-  3325,  6825, 25275
-};
+static const uint32 toc_dungeon[13] =
+{
+  2250, 22950, 16350, 24900, 13875, 19950, 13800, 15375, 17400, 17100,
+  3325,  6825, 25275
+};
+
+static const uint32 toc_ffight[26] =
+{
+  11994, 9742, 10136, 9685, 9553, 14588, 9430, 8721, 9975, 9764,
+  9704, 12796, 585, 754, 951, 624, 9047, 1068, 817, 9191, 1024,
+  14562, 10320, 8627, 3795, 3047
+};
+
+static const uint32 toc_ffightj[29] =
+{
+  11994, 9752, 10119, 9690, 9567, 14575, 9431, 8731, 9965, 9763,
+  9716, 12791, 579, 751, 958, 630, 9050, 1052, 825, 9193, 1026,
+  14553, 9834, 10542, 1699, 1792, 1781, 3783, 3052
+};
+
+
+/* supported audio file extensions */
+static const char extensions[SUPPORTED_EXT][16] =
+{
+#if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
+  "%02d.ogg",
+  " %02d.ogg",
+  "-%02d.ogg",
+  "_%02d.ogg",
+  " - %02d.ogg",
+  "%d.ogg",
+  " %d.ogg",
+  "-%d.ogg",
+  "_%d.ogg",
+  " - %d.ogg",
+#endif
+  "%02d.wav",
+  " %02d.wav",
+  "-%02d.wav",
+  "_%02d.wav",
+  " - %02d.wav",
+  "%d.wav",
+  " %d.wav",
+  "-%d.wav",
+  "_%d.wav",
+  " - %d.wav"
+};
+
+#if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
+
+static int seek64_wrap(void *f,ogg_int64_t off,int whence){
+  return cdStreamSeek(f,off,whence);
+}
+
+static ov_callbacks cb =
+{ 
+  (size_t (*)(void *, size_t, size_t, void *))  cdStreamRead,
+  (int (*)(void *, ogg_int64_t, int))           seek64_wrap,
+  (int (*)(void *))                             cdStreamClose,
+  (long (*)(void *))                            cdStreamTell
+};
+
+#ifdef DISABLE_MANY_OGG_OPEN_FILES
+static void ogg_free(int i)
+{
+  /* clear OGG file descriptor to prevent file from being closed */
+  cdd.toc.tracks[i].vf.datasource = NULL;
+
+  /* close VORBIS file structure */
+  ov_clear(&cdd.toc.tracks[i].vf);
+
+  /* indicates that the track is a seekable VORBIS file */
+  cdd.toc.tracks[i].vf.seekable = 1;
+
+  /* reset file reading position */
+  cdStreamSeek(cdd.toc.tracks[i].fd, 0, SEEK_SET);
+}
+#endif
+
+#ifdef USE_OGG_THREAD
+/* number of CD-DA sectors decoded ahead of current playing position */
+#ifndef OGG_PREFETCH_SECTORS
+#define OGG_PREFETCH_SECTORS 75
+#endif
+
+/* decoded PCM ring buffer size (must be a power of two) */
+#define OGG_RING_SIZE 0x40000
+#if (OGG_PREFETCH_SECTORS * 2352) > OGG_RING_SIZE
+#error "OGG_PREFETCH_SECTORS exceeds decoded PCM ring buffer size"
+#endif
+
+/* VORBIS audio tracks are decoded ahead of playing position by a worker thread */
+static struct
+{
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t work;      /* signaled when worker has something to do */
+  pthread_cond_t data;      /* signaled when decoded data is available or worker is idle */
+  int started;
+  int disabled;
+  int quit;
+  int decoding;             /* worker is currently running ov_read() */
+  int eof;                  /* end of track (or decoding error) reached */
+  int index;                /* decoded track index (-1 if none) */
+  int generation;           /* incremented each time decoding is restarted */
+  int offset;               /* track sample offset of first available PCM sample */
+  unsigned int head;        /* number of decoded bytes (written by worker thread) */
+  unsigned int tail;        /* number of consumed bytes (written by emulation thread) */
+  uint8 ring[OGG_RING_SIZE];
+} ogg_thread;
+
+static void *ogg_thread_main(void *arg)
+{
+  static char buffer[4096];
+
+  pthread_mutex_lock(&ogg_thread.mutex);
+
+  while (1)
+  {
+    int len, generation;
+    unsigned int size;
+    OggVorbis_File *vf;
+
+    /* wait until a track is being played and decoded data is running low */
+    while (!ogg_thread.quit && ((ogg_thread.index < 0) || ogg_thread.eof ||
+           ((ogg_thread.head - ogg_thread.tail) >= (OGG_PREFETCH_SECTORS * 2352))))
+    {
+      pthread_cond_wait(&ogg_thread.work, &ogg_thread.mutex);
+    }
+
+    if (ogg_thread.quit)
+    {
+      pthread_mutex_unlock(&ogg_thread.mutex);
+      return NULL;
+    }
+
+    vf = &cdd.toc.tracks[ogg_thread.index].vf;
+    generation = ogg_thread.generation;
+    size = (OGG_PREFETCH_SECTORS * 2352) - (ogg_thread.head - ogg_thread.tail);
+    if (size > sizeof(buffer)) size = sizeof(buffer);
+    ogg_thread.decoding = 1;
+    pthread_mutex_unlock(&ogg_thread.mutex);
+
+    /* decode next PCM samples */
+#ifdef USE_LIBVORBIS
+    len = ov_read(vf, buffer, size, 0, 2, 1, 0);
+#else
+    len = ov_read(vf, buffer, size, 0);
+#endif
+
+    pthread_mutex_lock(&ogg_thread.mutex);
+    ogg_thread.decoding = 0;
+
+    /* discard decoded data if decoding was restarted in the meantime */
+    if (generation == ogg_thread.generation)
+    {
+      if (len <= 0)
+      {
+        ogg_thread.eof = 1;
+      }
+      else
+      {
+        /* copy decoded samples (ring buffer might wrap once) */
+        unsigned int pos = ogg_thread.head & (OGG_RING_SIZE - 1);
+        unsigned int n = OGG_RING_SIZE - pos;
+        if (n > (unsigned int)len) n = len;
+        memcpy(&ogg_thread.ring[pos], buffer, n);
+        memcpy(&ogg_thread.ring[0], buffer + n, len - n);
+        ogg_thread.head += len;
+      }
+    }
+
+    pthread_cond_broadcast(&ogg_thread.data);
+  }
+}
+
+static void ogg_thread_start(void)
+{
+  /* both threads would compete for the same CPU */
+  if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+  {
+    ogg_thread.disabled = 1;
+    return;
+  }
+
+  pthread_mutex_init(&ogg_thread.mutex, NULL);
+  pthread_cond_init(&ogg_thread.work, NULL);
+  pthread_cond_init(&ogg_thread.data, NULL);
+  ogg_thread.quit = ogg_thread.decoding = ogg_thread.eof = 0;
+  ogg_thread.index = -1;
+  ogg_thread.head = ogg_thread.tail = 0;
+  if (pthread_create(&ogg_thread.thread, NULL, ogg_thread_main, NULL))
+  {
+    /* fallback to synchronous VORBIS decoding */
+    pthread_cond_destroy(&ogg_thread.data);
+    pthread_cond_destroy(&ogg_thread.work);
+    pthread_mutex_destroy(&ogg_thread.mutex);
+    ogg_thread.disabled = 1;
+    return;
+  }
+
+  ogg_thread.started = 1;
+}
+
+/* Cancel any decoding, VORBIS file structures can then be safely accessed */
+static void ogg_thread_cancel(void)
+{
+  if (ogg_thread.started)
+  {
+    pthread_mutex_lock(&ogg_thread.mutex);
+    ogg_thread.index = -1;
+    ogg_thread.generation++;
+    while (ogg_thread.decoding)
+    {
+      pthread_cond_wait(&ogg_thread.data, &ogg_thread.mutex);
+    }
+    pthread_mutex_unlock(&ogg_thread.mutex);
+  }
+}
+
+/* Start decoding VORBIS track from its current position */
+static void ogg_thread_play(int index)
+{
+  if (!ogg_thread.started)
+  {
+    if (ogg_thread.disabled) return;
+    ogg_thread_start();
+    if (!ogg_thread.started) return;
+  }
+
+  pthread_mutex_lock(&ogg_thread.mutex);
+  ogg_thread.offset = ov_pcm_tell(&cdd.toc.tracks[index].vf);
+  ogg_thread.head = ogg_thread.tail = 0;
+  ogg_thread.eof = 0;
+  ogg_thread.index = index;
+  pthread_cond_signal(&ogg_thread.work);
+  pthread_mutex_unlock(&ogg_thread.mutex);
+}
+
+/* Read decoded PCM data (returns number of bytes read) */
+static int ogg_thread_read(uint8 *dst, int length)
+{
+  int done = 0;
+
+  pthread_mutex_lock(&ogg_thread.mutex);
+
+  while (done < length)
+  {
+    unsigned int avail = ogg_thread.head - ogg_thread.tail;
+    unsigned int pos, n;
+
+    /* wait until more data has been decoded */
+    if (!avail)
+    {
+      if (ogg_thread.eof) break;
+      pthread_cond_wait(&ogg_thread.data, &ogg_thread.mutex);
+      continue;
+    }
+
+    if (avail > (unsigned int)(length - done)) avail = length - done;
+
+    /* copy decoded samples (ring buffer might wrap once) */
+    pos = ogg_thread.tail & (OGG_RING_SIZE - 1);
+    n = OGG_RING_SIZE - pos;
+    if (n > avail) n = avail;
+    memcpy(dst + done, &ogg_thread.ring[pos], n);
+    memcpy(dst + done + n, &ogg_thread.ring[0], avail - n);
+    ogg_thread.tail += avail;
+    done += avail;
+
+    /* request more data */
+    pthread_cond_signal(&ogg_thread.work);
+  }
+
+  /* update current playing position */
+  ogg_thread.offset += done / 4;
+
+  pthread_mutex_unlock(&ogg_thread.mutex);
+
+  return done;
+}
+
+static void ogg_thread_stop(void)
+{
+  if (ogg_thread.started)
+  {
+    pthread_mutex_lock(&ogg_thread.mutex);
+    ogg_thread.quit = 1;
+    pthread_cond_signal(&ogg_thread.work);
+    pthread_mutex_unlock(&ogg_thread.mutex);
+
+    pthread_join(ogg_thread.thread, NULL);
+    pthread_cond_destroy(&ogg_thread.data);
+    pthread_cond_destroy(&ogg_thread.work);
+    pthread_mutex_destroy(&ogg_thread.mutex);
+    ogg_thread.started = 0;
+  }
+
+  ogg_thread.disabled = 0;
+}
+
+#define OGG_THREAD_CANCEL() ogg_thread_cancel()
+#endif
+
+#endif
+
+#ifndef USE_OGG_THREAD
+#define OGG_THREAD_CANCEL()
+#endif
+
+#if defined(USE_CD_MMAP) || defined(USE_CD_CACHE)
+/* maximal number of opened CD image files (image file, track files & subcode data file) */
+#define CD_MAX_FILES 102
+
+/* opened CD image file */
+typedef struct
+{
+  cdStream *fd;         /* file stream */
+  char path[256];       /* file name */
+#ifdef USE_CD_MMAP
+  uint8 *data;          /* mapped file data (NULL if not mapped) */
+  size_t size;          /* mapped file size */
+  size_t pos;           /* current read offset */
+  size_t advised[2];    /* file area already advised as needed */
+#endif
+} cdd_file_t;
+
+static cdd_file_t cdd_files[CD_MAX_FILES];
+static int cdd_file_count;
+
+static void cdd_file_add(cdStream *fd, const char *fname)
+{
+  /* remember file name, in case file is used as a track file */
+  if (fd && (cdd_file_count < CD_MAX_FILES) && (strlen(fname) < sizeof(cdd_files[0].path)))
+  {
+    memset(&cdd_files[cdd_file_count], 0, sizeof(cdd_file_t));
+    cdd_files[cdd_file_count].fd = fd;
+    strcpy(cdd_files[cdd_file_count].path, fname);
+    cdd_file_count++;
+  }
+}
+
+static cdd_file_t *cdd_file_find(cdStream *fd)
+{
+  int i;
+
+  /* most recently opened file first (stream pointer could have been reused by a closed file) */
+  for (i=cdd_file_count-1; i>=0; i--)
+  {
+    if (cdd_files[i].fd == fd)
+    {
+      return &cdd_files[i];
+    }
+  }
+
+  return NULL;
+}
+
+static cdStream *cdd_stream_open(const char *fname)
+{
+  cdStream *fd = cdStreamOpen(fname);
+  cdd_file_add(fd, fname);
+  return fd;
+}
+#else
+#define cdd_stream_open(fname) cdStreamOpen(fname)
+#endif
+
+#ifdef USE_CD_MMAP
+/* size of track file area advised as needed ahead of CD drive head */
+#define CD_MMAP_PREFETCH (75 * 2352)
+
+static cdd_file_t *cdd_track_map[100];
+
+static void cdd_map_advise(cdd_file_t *map)
+{
+  /* advise file area ahead of current read offset when leaving previously advised area */
+  if ((map->pos < map->advised[0]) || ((map->pos + CD_MMAP_PREFETCH / 2) > map->advised[1]))
+  {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t start = map->pos & ~(page - 1);
+    size_t end = start + CD_MMAP_PREFETCH;
+    if (start >= map->size) return;
+    if (end > map->size) end = map->size;
+    posix_madvise(map->data + start, end - start, POSIX_MADV_WILLNEED);
+    map->advised[0] = start;
+    map->advised[1] = end;
+  }
+}
+
+static void cdd_map_tracks(void)
+{
+  int i;
+
+  for (i=0; i<cdd.toc.last; i++)
+  {
+    cdd_file_t *map;
+
+#if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
+    /* VORBIS files are decoded from stream */
+    if (cdd.toc.tracks[i].vf.seekable) continue;
+#endif
+
+    if (!cdd.toc.tracks[i].fd) continue;
+
+    /* find track file name */
+    map = cdd_file_find(cdd.toc.tracks[i].fd);
+    if (!map) continue;
+
+    /* map track file (once for consecutive tracks using the same file) */
+    if (!map->data)
+    {
+      struct stat st;
+      int fd = open(map->path, O_RDONLY);
+      if (fd < 0) continue;
+
+      if (!fstat(fd, &st) && S_ISREG(st.st_mode) && (st.st_size > 0))
+      {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+          posix_madvise(data, st.st_size, POSIX_MADV_SEQUENTIAL);
+          map->data = (uint8 *)data;
+          map->size = st.st_size;
+          map->pos = 0;
+          map->advised[0] = map->advised[1] = 0;
+        }
+      }
+
+      /* mapping remains valid once file descriptor is closed */
+      close(fd);
+    }
+
+    if (map->data)
+    {
+      cdd_track_map[i] = map;
+    }
+  }
+}
+
+static void cdd_unmap_tracks(void)
+{
+  int i;
+
+  for (i=0; i<cdd_file_count; i++)
+  {
+    if (cdd_files[i].data)
+    {
+      munmap(cdd_files[i].data, cdd_files[i].size);
+      cdd_files[i].data = NULL;
+    }
+  }
+
+  memset(cdd_track_map, 0, sizeof(cdd_track_map));
+}
+#endif
+
+/* Track file access (memory-mapped file or stream) */
+static void cdd_track_seek(int index, long offset)
+{
+#ifdef USE_CD_MMAP
+  cdd_file_t *map = cdd_track_map[index];
+  if (map)
+  {
+    map->pos = (offset > 0) ? offset : 0;
+    cdd_map_advise(map);
+    return;
+  }
+#endif
+  cdStreamSeek(cdd.toc.tracks[index].fd, offset, SEEK_SET);
+}
+
+static long cdd_track_tell(int index)
+{
+#ifdef USE_CD_MMAP
+  cdd_file_t *map = cdd_track_map[index];
+  if (map)
+  {
+    return map->pos;
+  }
+#endif
+  return cdStreamTell(cdd.toc.tracks[index].fd);
+}
+
+static int cdd_track_read(int index, void *dst, int length)
+{
+#ifdef USE_CD_MMAP
+  cdd_file_t *map = cdd_track_map[index];
+  if (map)
+  {
+    if (map->pos >= map->size) return 0;
+    if ((size_t)length > (map->size - map->pos)) length = map->size - map->pos;
+    memcpy(dst, map->data + map->pos, length);
+    map->pos += length;
+    cdd_map_advise(map);
+    return length;
+  }
+#endif
+  return cdStreamRead(dst, 1, length, cdd.toc.tracks[index].fd);
+}
+
+#ifdef USE_CD_CACHE
+/* cache file format version */
+#define CD_CACHE_VERSION 2
+
+/* cache file audio data alignment */
+#define CD_CACHE_ALIGN 4096
+
+/* number of sectors converted at once when creating cache file */
+#define CD_CACHE_SECTORS 75
+
+/* source files data read at start and end of each file to identify source image file */
+#define CD_CACHE_KEY_DATA 0x10000
+
+/* maximal cache directory size in MB (least recently used cache files are removed first) */
+#ifndef CD_CACHE_MAX_SIZE
+#define CD_CACHE_MAX_SIZE 4096
+#endif
+
+/* maximal number of cache files */
+#define CD_CACHE_MAX_FILES 256
+
+/* cached audio tracks source type */
+#define CD_CACHE_SRC_PCM 0
+#define CD_CACHE_SRC_OGG 1
+#define CD_CACHE_SRC_CHD 2
+
+/* cached track */
+typedef struct
+{
+  int start;
+  int end;
+  int type;
+  int loopEnabled;
+  int loopOffset;
+  int source;       /* source file type */
+  int offset;       /* source file read offset (used for savestates compatibility) */
+} cdd_cache_track_t;
+
+/* cache file trailer (stored in host byte order after sectors data) */
+typedef struct
+{
+  char magic[8];
+  uint32 version;
+  uint32 key[2];    /* source data length & CRC */
+  int sectorSize;
+  int end;
+  int last;
+  int loaded;
+  int hasSub;
+  int audioLba;     /* first audio sector */
+  int audioBase;    /* first audio sector offset in cache file */
+  cdd_cache_track_t tracks[100];
+} cdd_cache_t;
+
+/* cache directory index entry */
+typedef struct
+{
+  uint32 key[2];
+  uint32 size;      /* cache files size (KB) */
+  uint32 used;      /* last use sequence number */
+} cdd_cache_entry_t;
+
+/* cache directory index (stored in host byte order) */
+typedef struct
+{
+  char magic[8];
+  uint32 count;
+  uint32 used;      /* last use sequence number */
+  cdd_cache_entry_t entries[CD_CACHE_MAX_FILES];
+} cdd_cache_index_t;
+
+/* cache file source data (opened separately from emulated CD image files) */
+typedef struct
+{
+  int index;                /* track index of opened source file (-1 if none) */
+  cdStream *fd;
+#if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
+  OggVorbis_File vf;
+#endif
+#if defined(USE_LIBCHDR)
+  chd_file *chd;
+  uint8 *hunk;
+  int hunkbytes;
+  int hunknum;
+#endif
+} cdd_cache_src_t;
+
+/* cache file is created by a worker thread, from source image files opened again */
+static struct
+{
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  int started;
+  int quit;
+  uint32 key[2];
+  cdd_cache_t cache;        /* created cache file trailer */
+  char files[100][256];     /* track files (CHD image file) */
+  char sub[256];            /* subcode data file */
+} cdd_cache_job;
+
+static cdd_cache_t cdd_cache;
+static int cdd_cache_active;
+
+static void cdd_cache_key_data(cdStream *fd, uint8 *buf, uint32 *key)
+{
+  long size, pos;
+  int len;
+
+  /* file reading position is preserved (VORBIS decoder) */
+  pos = cdStreamTell(fd);
+  cdStreamSeek(fd, 0, SEEK_END);
+  size = cdStreamTell(fd);
+  key[0] += size;
+
+  /* file start */
+  len = (size < CD_CACHE_KEY_DATA) ? size : CD_CACHE_KEY_DATA;
+  cdStreamSeek(fd, 0, SEEK_SET);
+  len = cdStreamRead(buf, 1, len, fd);
+  if (len > 0)
+  {
+    key[1] = crc32(key[1], buf, len);
+  }
+
+  /* file end (if not already read) */
+  if (size > CD_CACHE_KEY_DATA)
+  {
+    len = ((size - CD_CACHE_KEY_DATA) < CD_CACHE_KEY_DATA) ? (size - CD_CACHE_KEY_DATA) : CD_CACHE_KEY_DATA;
+    cdStreamSeek(fd, size - len, SEEK_SET);
+    len = cdStreamRead(buf, 1, len, fd);
+    if (len > 0)
+    {
+      key[1] = crc32(key[1], buf, len);
+    }
+  }
+
+  cdStreamSeek(fd, pos, SEEK_SET);
+}
+
+static int cdd_cache_key(uint32 *key)
+{
+  uint8 *buf;
+  int i, j;
+
+#if defined(USE_LIBCHDR)
+  if (cdd.chd.file)
+  {
+    /* CHD logical data length & CRC of CHD header data checksums */
+    const chd_header *head = chd_get_header(cdd.chd.file);
+    key[0] = (uint32)head->logicalbytes;
+    key[1] = crc32(0, head->md5, sizeof(head->md5));
+    key[1] = crc32(key[1], head->sha1, sizeof(head->sha1));
+    key[1] = crc32(key[1], head->rawsha1, sizeof(head->rawsha1));
+    return 1;
+  }
+#endif
+
+  buf = (uint8 *)malloc(CD_CACHE_KEY_DATA);
+  if (!buf)
+  {
+    return 0;
+  }
+
+  /* CRC of TOC (as parsed from CUE or TOC file) */
+  key[0] = key[1] = 0;
+  for (i=0; i<cdd.toc.last; i++)
+  {
+    int toc[6];
+    toc[0] = cdd.toc.tracks[i].start;
+    toc[1] = cdd.toc.tracks[i].end;
+    toc[2] = cdd.toc.tracks[i].type;
+    toc[3] = cdd.toc.tracks[i].offset;
+    toc[4] = cdd.toc.tracks[i].loopEnabled;
+    toc[5] = cdd.toc.tracks[i].loopOffset;
+    key[1] = crc32(key[1], (uint8 *)toc, sizeof(toc));
+  }
+
+  /* total length of all track files and subcode data file & CRC of data at start and end of each file */
+  /* (reading all files would take several seconds on each load, for large images stored on slow devices) */
+  for (i=0; i<=cdd.toc.last; i++)
+  {
+    cdStream *fd = (i < cdd.toc.last) ? cdd.toc.tracks[i].fd : cdd.toc.sub;
+
+    if (!fd)
+    {
+      continue;
+    }
+
+    /* skip files already used by previous tracks */
+    for (j=0; (j<i) && (j<cdd.toc.last) && (cdd.toc.tracks[j].fd != fd); j++);
+    if (j < i)
+    {
+      continue;
+    }
+
+    cdd_cache_key_data(fd, buf, key);
+  }
+
+  free(buf);
+  return 1;
+}
+
+static int cdd_cache_path(char *path, const uint32 *key, const char *ext)
+{
+  /* cache disabled or directory path too long */
+  if (!CD_CACHE_DIR[0] || (strlen(CD_CACHE_DIR) > 255))
+  {
+    return 0;
+  }
+
+  sprintf(path, "%s/%08x%08x.%s", CD_CACHE_DIR, key[0], key[1], ext);
+  return 1;
+}
+
+static void cdd_cache_temp(char *temp, const char *path)
+{
+  /* unique temporary file name, as several instances could create the same cache file */
+  sprintf(temp, "%s.%08x.tmp", path, (uint32)time(NULL) ^ (uint32)clock() ^ (uint32)(size_t)temp);
+}
+
+static int cdd_cache_evict(cdd_cache_index_t *index, const uint32 *key)
+{
+  char path[256+32];
+  int i, lru = -1;
+
+  /* least recently used cache file (current cache file is never removed) */
+  for (i=0; i<(int)index->count; i++)
+  {
+    if ((index->entries[i].key[0] == key[0]) && (index->entries[i].key[1] == key[1]))
+    {
+      continue;
+    }
+
+    if ((lru < 0) || (index->entries[i].used < index->entries[lru].used))
+    {
+      lru = i;
+    }
+  }
+
+  if (lru < 0)
+  {
+    return 0;
+  }
+
+  /* remove cache files (an instance using them keeps them opened) */
+  if (cdd_cache_path(path, index->entries[lru].key, "bin"))
+  {
+    cdCacheRemove(path);
+    cdd_cache_path(path, index->entries[lru].key, "sub");
+    cdCacheRemove(path);
+  }
+
+  index->entries[lru] = index->entries[--index->count];
+  return 1;
+}
+
+static void cdd_cache_index_update(const uint32 *key, uint32 size)
+{
+  cdd_cache_index_t index;
+  char path[256+32];
+  char temp[256+48];
+  cdStream *fd;
+  uint32 total;
+  int i, ok;
+
+  if (!CD_CACHE_DIR[0] || (strlen(CD_CACHE_DIR) > 255))
+  {
+    return;
+  }
+
+  sprintf(path, "%s/index.dat", CD_CACHE_DIR);
+
+  /* read cache directory index */
+  memset(&index, 0, sizeof(index));
+  fd = cdStreamOpen(path);
+  if (fd)
+  {
+    if ((cdStreamRead(&index, 1, sizeof(index), fd) != sizeof(index)) ||
+        memcmp(index.magic, "GPGXCDI", 8) || (index.count > CD_CACHE_MAX_FILES))
+    {
+      memset(&index, 0, sizeof(index));
+    }
+    cdStreamClose(fd);
+  }
+
+  memcpy(index.magic, "GPGXCDI", 8);
+
+  /* find cache file entry (or add it, removing least recently used cache file if index is full) */
+  for (i=0; i<(int)index.count; i++)
+  {
+    if ((index.entries[i].key[0] == key[0]) && (index.entries[i].key[1] == key[1]))
+    {
+      break;
+    }
+  }
+
+  if (i == (int)index.count)
+  {
+    if ((index.count == CD_CACHE_MAX_FILES) && !cdd_cache_evict(&index, key))
+    {
+      return;
+    }
+
+    i = index.count++;
+    index.entries[i].key[0] = key[0];
+    index.entries[i].key[1] = key[1];
+  }
+
+  /* update cache file size & last use */
+  index.entries[i].size = size;
+  index.entries[i].used = ++index.used;
+
+  /* remove least recently used cache files until cache directory size limit is respected */
+  do
+  {
+    for (i=0, total=0; i<(int)index.count; i++)
+    {
+      total += index.entries[i].size;
+    }
+  }
+  while ((total > (CD_CACHE_MAX_SIZE * 1024)) && cdd_cache_evict(&index, key));
+
+  /* write cache directory index (replaces existing one at once, as several instances could use it) */
+  cdd_cache_temp(temp, path);
+  fd = cdStreamCreate(temp);
+  if (!fd)
+  {
+    return;
+  }
+
+  ok = (cdStreamWrite(&index, 1, sizeof(index), fd) == sizeof(index));
+  if (cdStreamClose(fd))
+  {
+    ok = 0;
+  }
+
+  if (!ok)
+  {
+    cdCacheRemove(temp);
+  }
+  else if (cdCacheRename(temp, path))
+  {
+    /* existing file is not replaced on all platforms */
+    cdCacheRemove(path);
+    if (cdCacheRename(temp, path))
+    {
+      cdCacheRemove(temp);
+    }
+  }
+}
+
+static cdStream *cdd_cache_open(const uint32 *key, long *size)
+{
+  char path[256+32];
+  cdStream *fd;
+
+  if (!cdd_cache_path(path, key, "bin"))
+  {
+    return NULL;
+  }
+
+  fd = cdStreamOpen(path);
+  if (!fd)
+  {
+    return NULL;
+  }
+
+  /* read cache file trailer */
+  cdStreamSeek(fd, 0, SEEK_END);
+  *size = cdStreamTell(fd);
+  if ((*size < (long)sizeof(cdd_cache)) ||
+      cdStreamSeek(fd, *size - sizeof(cdd_cache), SEEK_SET) ||
+      (cdStreamRead(&cdd_cache, 1, sizeof(cdd_cache), fd) != sizeof(cdd_cache)))
+  {
+    cdStreamClose(fd);
+    return NULL;
+  }
+
+  /* check cache file is complete and matches source image file */
+  if (memcmp(cdd_cache.magic, "GPGXCDC", 8) || (cdd_cache.version != CD_CACHE_VERSION) ||
+      (cdd_cache.key[0] != key[0]) || (cdd_cache.key[1] != key[1]) ||
+      (cdd_cache.last <= 0) || (cdd_cache.last > 99) ||
+      (*size != (cdd_cache.audioBase + (long)(cdd_cache.end - cdd_cache.audioLba) * 2352 + (long)sizeof(cdd_cache))))
+  {
+    cdStreamClose(fd);
+    return NULL;
+  }
+
+  return fd;
+}
+
+static void cdd_cache_mount(cdStream *fd, const uint32 *key, char *header)
+{
+  char path[256+32];
+  int i, offset;
+
+  /* audio tracks read offset (all audio sectors are stored consecutively) */
+  offset = (cdd_cache.audioLba * 2352) - cdd_cache.audioBase;
+
+  /* initialize TOC */
+  for (i=0; i<cdd_cache.last; i++)
+  {
+    cdd.toc.tracks[i].fd = fd;
+    cdd.toc.tracks[i].start = cdd_cache.tracks[i].start;
+    cdd.toc.tracks[i].end = cdd_cache.tracks[i].end;
+    cdd.toc.tracks[i].type = cdd_cache.tracks[i].type;
+    cdd.toc.tracks[i].loopEnabled = cdd_cache.tracks[i].loopEnabled;
+    cdd.toc.tracks[i].loopOffset = cdd_cache.tracks[i].loopOffset;
+    cdd.toc.tracks[i].offset = cdd_cache.tracks[i].type ? 0 : offset;
+  }
+  cdd.toc.last = cdd_cache.last;
+  cdd.toc.end = cdd_cache.end;
+  cdd.sectorSize = cdd_cache.sectorSize;
+
+  /* Lead-out */
+  cdd.toc.tracks[cdd.toc.last].start = cdd.toc.end;
+
+  /* read CD image header + security code (skip RAW sector 16-byte header) */
+  if (cdd.toc.tracks[0].type)
+  {
+    cdStreamSeek(fd, (cdd.sectorSize == 2048) ? 0 : 16, SEEK_SET);
+    cdStreamRead(header, 0x210, 1, fd);
+  }
+  cdStreamSeek(fd, 0, SEEK_SET);
+
+  /* CD mounted */
+  cdd.loaded = cdd_cache.loaded;
+  cdd_cache_active = 1;
+
+  /* cache file is used as track file */
+  cdd_cache_path(path, key, "bin");
+  cdd_file_add(fd, path);
+
+#ifdef USE_CD_MMAP
+  /* map cache file in memory when possible */
+  cdd_map_tracks();
+#endif
+
+  /* subcode data file */
+  if (cdd_cache.hasSub && cdd_cache_path(path, key, "sub"))
+  {
+    cdd.toc.sub = cdStreamOpen(path);
+  }
+}
+
+static int cdd_cache_cancelled(void)
+{
+  int quit;
+  pthread_mutex_lock(&cdd_cache_job.mutex);
+  quit = cdd_cache_job.quit;
+  pthread_mutex_unlock(&cdd_cache_job.mutex);
+  return quit;
+}
+
+static int cdd_cache_write(cdStream *fd, const void *data, int length, long *size)
+{
+  /* cache file creation is aborted when disc is unloaded */
+  if (cdd_cache_cancelled())
+  {
+    return 0;
+  }
+
+  *size += length;
+  return cdStreamWrite(data, 1, length, fd) == length;
+}
+
+static int cdd_cache_src_init(cdd_cache_src_t *src)
+{
+  memset(src, 0, sizeof(cdd_cache_src_t));
+  src->index = -1;
+
+#if defined(USE_LIBCHDR)
+  if (cdd_cache_job.cache.tracks[0].source == CD_CACHE_SRC_CHD)
+  {
+    /* CHD image file is used for all tracks */
+    src->fd = cdStreamOpen(cdd_cache_job.files[0]);
+    if (!src->fd)
+    {
+      return 0;
+    }
+
+    if (chd_open_file(src->fd, CHD_OPEN_READ, NULL, &src->chd) != CHDERR_NONE)
+    {
+      chd_close(src->chd);
+      cdStreamClose(src->fd);
+      return 0;
+    }
+
+    src->hunkbytes = chd_get_header(src->chd)->hunkbytes;
+    src->hunknum = -1;
+    src->hunk = (uint8 *)malloc(src->hunkbytes);
+    if (!src->hunk)
+    {
+      chd_close(src->chd);
+      cdStreamClose(src->fd);
+      return 0;
+    }
+  }
+#endif
+
+  return 1;
+}
+
+static void cdd_cache_src_close(cdd_cache_src_t *src)
+{
+#if defined(USE_LIBCHDR)
+  if (src->chd)
+  {
+    chd_close(src->chd);
+    free(src->hunk);
+    src->chd = NULL;
+  }
+#endif
+
+#if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
+  if (src->vf.datasource)
+  {
+    /* VORBIS decoder also closes track file */
+    ov_clear(&src->vf);
+    src->fd = NULL;
+  }
+#endif
+
+  if (src->fd)
+  {
+    cdStreamClose(src->fd);
+    src->fd = NULL;
+  }
+
+  src->index = -1;
+}
+
+static int cdd_cache_src_open(cdd_cache_src_t *src, int index, int lba)
+{
+  cdd_cache_track_t *track = &cdd_cache_job.cache.tracks[index];
+
+#if defined(USE_LIBCHDR)
+  if (src->chd)
+  {
+    /* CHD image file is already opened */
+    src->index = index;
+    return 1;
+  }
+#endif
+
+  /* open track file */
+  cdd_cache_src_close(src);
+  src->fd = cdStreamOpen(cdd_cache_job.files[index]);
+  if (!src->fd)
+  {
+    return 0;
+  }
+
+  src->index = index;
+
+#if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
+  if (track->source == CD_CACHE_SRC_OGG)
+  {
+    /* VORBIS file is closed with its decoder */
+    if (ov_open_callbacks(src->fd,&src->vf,0,0,cb))
+    {
+      cdStreamClose(src->fd);
+      src->fd = NULL;
+      src->index = -1;
+      return 0;
+    }
+
+    return !ov_pcm_seek(&src->vf, (lba * 588) - track->offset);
+  }
+#endif
+
+  /* DATA track sectors are read from file start */
+  return !cdStreamSeek(src->fd, track->type ? 0 : ((lba * 2352) - track->offset), SEEK_SET);
+}
+
+#if defined(USE_LIBCHDR)
+static uint8 *cdd_cache_src_sector(cdd_cache_src_t *src, int index, int lba)
+{
+  /* CHD file offset (sectors never cross hunks boundaries) */
+  int offset = cdd_cache_job.cache.tracks[index].offset + (lba * CD_FRAME_SIZE);
+  int hunknum = offset / src->hunkbytes;
+
+  if (hunknum != src->hunknum)
+  {
+    if (chd_read(src->chd, hunknum, src->hunk) != CHDERR_NONE)
+    {
+      memset(src->hunk, 0, src->hunkbytes);
+    }
+    src->hunknum = hunknum;
+  }
+
+  return src->hunk + (offset % src->hunkbytes);
+}
+#endif
+
+static void cdd_cache_src_read_data(cdd_cache_src_t *src, uint8 *dst, int lba)
+{
+  int sectorSize = cdd_cache_job.cache.sectorSize;
+  int len;
+
+#if defined(USE_LIBCHDR)
+  if (src->chd)
+  {
+    memcpy(dst, cdd_cache_src_sector(src, 0, lba), sectorSize);
+    return;
+  }
+#endif
+
+  len = cdStreamRead(dst, 1, sectorSize, src->fd);
+  if (len < 0) len = 0;
+  memset(dst + len, 0, sectorSize - len);
+}
+
+static void cdd_cache_src_read_audio(cdd_cache_src_t *src, uint8 *dst, int lba, int sectors)
+{
+  int length = sectors * 2352;
+  int done = 0;
+
+#if defined(USE_LIBCHDR)
+  if (src->chd)
+  {
+    /* 16-bit (big-endian) stereo samples, followed by subcode data */
+    for (; done<length; done+=2352, lba++)
+    {
+      uint8 *sector = cdd_cache_src_sector(src, src->index, lba);
+      int i;
+      for (i=0; i<2352; i+=2)
+      {
+        dst[done + i] = sector[i + 1];
+        dst[done + i + 1] = sector[i];
+      }
+    }
+    return;
+  }
+#endif
+
+#if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
+  if (src->vf.datasource)
+  {
+    while (done < length)
+    {
+#ifdef USE_LIBVORBIS
+      int len = ov_read(&src->vf, (char *)(dst + done), length - done, 0, 2, 1, 0);
+#else
+      int len = ov_read(&src->vf, (char *)(dst + done), length - done, 0);
+#endif
+      if (len <= 0) break;
+      done += len;
+    }
+
+    /* end of track or decoding error */
+    memset(dst + done, 0, length - done);
+
+#ifndef LSB_FIRST
+    /* convert 16-bit (host-endian) samples to little-endian */
+    for (done=0; done<length; done+=2)
+    {
+      uint8 temp = dst[done];
+      dst[done] = dst[done + 1];
+      dst[done + 1] = temp;
+    }
+#endif
+    return;
+  }
+#endif
+
+  /* PCM files are already stored as 16-bit (little-endian) stereo samples */
+  done = cdStreamRead(dst, 1, length, src->fd);
+  if (done < 0) done = 0;
+  memset(dst + done, 0, length - done);
+}
+
+static int cdd_cache_copy(cdStream *dst, cdStream *src, uint8 *buf, long *size)
+{
+  int len;
+
+  while ((len = cdStreamRead(buf, 1, CD_CACHE_SECTORS * 2352, src)) > 0)
+  {
+    if (!cdd_cache_write(dst, buf, len, size))
+    {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static void *cdd_cache_create(void *arg)
+{
+  cdd_cache_t *cache = &cdd_cache_job.cache;
+  cdd_cache_src_t src;
+  char path[256+32];
+  char sub[256+32];
+  char temp[256+48];
+  char temp_sub[256+48];
+  uint8 *buf;
+  cdStream *f;
+  long size = 0, subSize = 0;
+  int i, lba, ok = 1;
+
+  if (!cdd_cache_path(path, cdd_cache_job.key, "bin"))
+  {
+    return NULL;
+  }
+
+  buf = (uint8 *)malloc(CD_CACHE_SECTORS * 2352);
+  if (!buf)
+  {
+    return NULL;
+  }
+
+  /* source image files are opened again, so that emulation is not affected */
+  if (!cdd_cache_src_init(&src))
+  {
+    free(buf);
+    return NULL;
+  }
+
+  /* cache file is written to a temporary file first */
+  cdd_cache_temp(temp, path);
+  f = cdStreamCreate(temp);
+  if (!f)
+  {
+    cdd_cache_src_close(&src);
+    free(buf);
+    return NULL;
+  }
+
+  /* DATA track sectors (stored with original sector size) */
+  if (cache->tracks[0].type)
+  {
+    ok = cdd_cache_src_open(&src, 0, 0);
+    for (lba=0; ok && (lba<cache->tracks[0].end); lba++)
+    {
+      cdd_cache_src_read_data(&src, buf, lba);
+      ok = cdd_cache_write(f, buf, cache->sectorSize, &size);
+    }
+
+    cache->audioLba = cache->tracks[0].end;
+  }
+
+  /* align AUDIO sectors to memory pages */
+  memset(buf, 0, CD_CACHE_ALIGN);
+  if (ok && (size % CD_CACHE_ALIGN))
+  {
+    ok = cdd_cache_write(f, buf, CD_CACHE_ALIGN - (size % CD_CACHE_ALIGN), &size);
+  }
+  cache->audioBase = size;
+
+  /* AUDIO sectors (16-bit little-endian stereo samples, from each track start to next track start) */
+  lba = cache->audioLba;
+  for (i=0; ok && (i<cache->last); i++)
+  {
+    int next = (i < (cache->last - 1)) ? cache->tracks[i + 1].start : cache->end;
+
+    if (cache->tracks[i].type || (next > cache->end))
+    {
+      continue;
+    }
+
+    /* PAUSE before current track start */
+    memset(buf, 0, CD_CACHE_SECTORS * 2352);
+    while (ok && (lba < cache->tracks[i].start))
+    {
+      int count = cache->tracks[i].start - lba;
+      if (count > CD_CACHE_SECTORS) count = CD_CACHE_SECTORS;
+      ok = cdd_cache_write(f, buf, count * 2352, &size);
+      lba += count;
+    }
+
+    /* open track file at track start */
+    ok = ok && cdd_cache_src_open(&src, i, lba);
+
+    /* decode track sectors */
+    while (ok && (lba < next))
+    {
+      int count = next - lba;
+      if (count > CD_CACHE_SECTORS) count = CD_CACHE_SECTORS;
+      cdd_cache_src_read_audio(&src, buf, lba, count);
+      ok = cdd_cache_write(f, buf, count * 2352, &size);
+      lba += count;
+    }
+  }
+
+  cdd_cache_src_close(&src);
+
+  /* PAUSE after last track */
+  memset(buf, 0, CD_CACHE_SECTORS * 2352);
+  while (ok && (lba < cache->end))
+  {
+    int count = cache->end - lba;
+    if (count > CD_CACHE_SECTORS) count = CD_CACHE_SECTORS;
+    ok = cdd_cache_write(f, buf, count * 2352, &size);
+    lba += count;
+  }
+
+  /* copy subcode data file */
+  if (ok && cdd_cache_job.sub[0] && cdd_cache_path(sub, cdd_cache_job.key, "sub"))
+  {
+    cdStream *s = cdStreamOpen(cdd_cache_job.sub);
+    if (s)
+    {
+      cdStream *d;
+      cdd_cache_temp(temp_sub, sub);
+      d = cdStreamCreate(temp_sub);
+      if (d)
+      {
+        cache->hasSub = cdd_cache_copy(d, s, buf, &subSize);
+        if (cdStreamClose(d) || !cache->hasSub)
+        {
+          /* cache file is used without subcode data file */
+          cache->hasSub = 0;
+          cdCacheRemove(temp_sub);
+        }
+        else if (cdCacheRename(temp_sub, sub))
+        {
+          /* subcode data file already created by another instance (which also creates cache file) */
+          cdCacheRemove(temp_sub);
+          ok = 0;
+        }
+      }
+      cdStreamClose(s);
+    }
+  }
+
+  /* trailer is written last so that incomplete cache files are ignored */
+  if (ok)
+  {
+    ok = cdd_cache_write(f, cache, sizeof(cdd_cache_t), &size);
+  }
+
+  if (cdStreamClose(f))
+  {
+    ok = 0;
+  }
+
+  /* complete cache file replaces any existing one at once, so that it is never seen partially written */
+  /* (if replacing fails, existing cache file was created by another instance from the same source data) */
+  if (!ok || cdCacheRename(temp, path))
+  {
+    cdCacheRemove(temp);
+  }
+  else
+  {
+    /* remove least recently used cache files if needed */
+    cdd_cache_index_update(cdd_cache_job.key, (uint32)((size + subSize + 1023) >> 10));
+  }
+
+  free(buf);
+  return NULL;
+}
+
+static void cdd_cache_start(char *filename, const uint32 *key)
+{
+  cdd_cache_t *cache = &cdd_cache_job.cache;
+  cdd_file_t *file;
+  int i;
+
+  memset(cache, 0, sizeof(cdd_cache_t));
+  memcpy(cache->magic, "GPGXCDC", 8);
+  cache->version = CD_CACHE_VERSION;
+  cache->key[0] = cdd_cache_job.key[0] = key[0];
+  cache->key[1] = cdd_cache_job.key[1] = key[1];
+  cache->sectorSize = cdd.sectorSize;
+  cache->end = cdd.toc.end;
+  cache->last = cdd.toc.last;
+  cache->loaded = cdd.loaded;
+
+  for (i=0; i<cdd.toc.last; i++)
+  {
+    cache->tracks[i].start = cdd.toc.tracks[i].start;
+    cache->tracks[i].end = cdd.toc.tracks[i].end;
+    cache->tracks[i].type = cdd.toc.tracks[i].type;
+    cache->tracks[i].loopEnabled = cdd.toc.tracks[i].loopEnabled;
+    cache->tracks[i].loopOffset = cdd.toc.tracks[i].loopOffset;
+    cache->tracks[i].offset = cdd.toc.tracks[i].offset;
+    cache->tracks[i].source = CD_CACHE_SRC_PCM;
+#if defined(USE_LIBCHDR)
+    if (cdd.chd.file)
+    {
+      cache->tracks[i].source = CD_CACHE_SRC_CHD;
+      continue;
+    }
+#endif
+#if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
+    if (cdd.toc.tracks[i].vf.seekable) cache->tracks[i].source = CD_CACHE_SRC_OGG;
+#endif
+
+    /* track file name */
+    file = cdd_file_find(cdd.toc.tracks[i].fd);
+    if (!file)
+    {
+      return;
+    }
+    strcpy(cdd_cache_job.files[i], file->path);
+  }
+
+#if defined(USE_LIBCHDR)
+  if (cdd.chd.file)
+  {
+    /* CHD image file name */
+    if (strlen(filename) >= sizeof(cdd_cache_job.files[0]))
+    {
+      return;
+    }
+    strcpy(cdd_cache_job.files[0], filename);
+  }
+#endif
+
+  /* subcode data file name */
+  file = cdd.toc.sub ? cdd_file_find(cdd.toc.sub) : NULL;
+  if (file)
+  {
+    strcpy(cdd_cache_job.sub, file->path);
+  }
+  else
+  {
+    cdd_cache_job.sub[0] = 0;
+  }
+
+  pthread_mutex_init(&cdd_cache_job.mutex, NULL);
+  cdd_cache_job.quit = 0;
+  if (pthread_create(&cdd_cache_job.thread, NULL, cdd_cache_create, NULL))
+  {
+    pthread_mutex_destroy(&cdd_cache_job.mutex);
+    return;
+  }
 
-static const uint32 toc_ffight[26] =
-{
-  11994, 9742, 10136, 9685, 9553, 14588, 9430, 8721, 9975, 9764,
-  9704, 12796, 585, 754, 951, 624, 9047, 1068, 817, 9191, 1024,
-  14562, 10320, 8627, 3795, 3047
-};
+  cdd_cache_job.started = 1;
+}
 
-static const uint32 toc_ffightj[29] =
+static void cdd_cache_stop(void)
 {
-  11994, 9752, 10119, 9690, 9567, 14575, 9431, 8731, 9965, 9763,
-  9716, 12791, 579, 751, 958, 630, 9050, 1052, 825, 9193, 1026,
-  14553, 9834, 10542, 1699, 1792, 1781, 3783, 3052
-};
-
+  if (cdd_cache_job.started)
+  {
+    /* abort cache file creation if not finished */
+    pthread_mutex_lock(&cdd_cache_job.mutex);
+    cdd_cache_job.quit = 1;
+    pthread_mutex_unlock(&cdd_cache_job.mutex);
+
+    pthread_join(cdd_cache_job.thread, NULL);
+    pthread_mutex_destroy(&cdd_cache_job.mutex);
+    cdd_cache_job.started = 0;
+  }
+}
 
-/* supported audio file extensions */
-static const char extensions[SUPPORTED_EXT][16] =
+static void cdd_cache_update(char *filename, char *header)
 {
+  uint32 key[2];
+  cdStream *fd;
+  long size;
+  int i, decode = 0;
+
+  /* only cache images with compressed tracks */
+#if defined(USE_LIBCHDR)
+  if (cdd.chd.file) decode = 1;
+#endif
+  for (i=0; i<cdd.toc.last; i++)
+  {
+    /* simulated tracks can not be cached */
+    if (!cdd.toc.tracks[i].fd) return;
 #if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
-  "%02d.ogg",
-  " %02d.ogg",
-  "-%02d.ogg",
-  "_%02d.ogg",
-  " - %02d.ogg",
-  "%d.ogg",
-  " %d.ogg",
-  "-%d.ogg",
-  "_%d.ogg",
-  " - %d.ogg",
+    if (cdd.toc.tracks[i].vf.seekable) decode = 1;
 #endif
-  "%02d.wav",
-  " %02d.wav",
-  "-%02d.wav",
-  "_%02d.wav",
-  " - %02d.wav",
-  "%d.wav",
-  " %d.wav",
-  "-%d.wav",
-  "_%d.wav",
-  " - %d.wav"
-};
+  }
 
-#if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
+  if (!decode || !CD_CACHE_DIR[0] || !cdd_cache_key(key))
+  {
+    return;
+  }
 
-static int seek64_wrap(void *f,ogg_int64_t off,int whence){
-  return cdStreamSeek(f,off,whence);
-}
+  /* check for previously decoded image file in cache directory */
+  fd = cdd_cache_open(key, &size);
+  if (fd)
+  {
+    /* replace source image files with cache file */
+    cdd_unload();
+    cdd_cache_mount(fd, key, header);
 
-static ov_callbacks cb =
-{ 
-  (size_t (*)(void *, size_t, size_t, void *))  cdStreamRead,
-  (int (*)(void *, ogg_int64_t, int))           seek64_wrap,
-  (int (*)(void *))                             cdStreamClose,
-  (long (*)(void *))                            cdStreamTell
-};
+    /* update cache file last use */
+    if (cdd.toc.sub)
+    {
+      cdStreamSeek(cdd.toc.sub, 0, SEEK_END);
+      size += cdStreamTell(cdd.toc.sub);
+      cdStreamSeek(cdd.toc.sub, 0, SEEK_SET);
+    }
+    cdd_cache_index_update(key, (uint32)((size + 1023) >> 10));
+  }
+  else if (sysconf(_SC_NPROCESSORS_ONLN) > 1)
+  {
+    /* store decoded image file in cache directory, in background */
+    /* (cache file creation would otherwise compete with emulation for the same CPU) */
+    cdd_cache_start(filename, key);
+  }
+}
 
-#ifdef DISABLE_MANY_OGG_OPEN_FILES
-static void ogg_free(int i)
+/* convert cache file read offset to source file read offset (and back) so that savestates remain compatible */
+static int cdd_cache_state_offset(int index, int offset)
 {
-  /* clear OGG file descriptor to prevent file from being closed */
-  cdd.toc.tracks[i].vf.datasource = NULL;
+  cdd_cache_track_t *track = &cdd_cache.tracks[index];
 
-  /* close VORBIS file structure */
-  ov_clear(&cdd.toc.tracks[i].vf);
+  /* absolute position (2352 bytes per sector) */
+  int pos = offset + cdd.toc.tracks[index].offset;
 
-  /* indicates that the track is a seekable VORBIS file */
-  cdd.toc.tracks[i].vf.seekable = 1;
+  switch (track->source)
+  {
+    case CD_CACHE_SRC_CHD:
+      return track->offset + ((pos / 2352) * 2448) + (pos % 2352);
 
-  /* reset file reading position */
-  cdStreamSeek(cdd.toc.tracks[i].fd, 0, SEEK_SET);
+    case CD_CACHE_SRC_OGG:
+      return (pos / 4) - track->offset;
+
+    default:
+      return pos - track->offset;
+  }
 }
-#endif
 
+static int cdd_cache_file_offset(int index, int offset)
+{
+  cdd_cache_track_t *track = &cdd_cache.tracks[index];
+  int pos;
+
+  switch (track->source)
+  {
+    case CD_CACHE_SRC_CHD:
+      offset -= track->offset;
+      pos = ((offset / 2448) * 2352) + (((offset % 2448) < 2352) ? (offset % 2448) : 2352);
+      break;
+
+    case CD_CACHE_SRC_OGG:
+      pos = (offset + track->offset) * 4;
+      break;
+
+    default:
+      pos = offset + track->offset;
+      break;
+  }
+
+  return pos - cdd.toc.tracks[index].offset;
+}
 #endif
 
-void cdd_init(int samplerate)
+void cdd_init(double samplerate)
 {
   /* CD-DA is running by default at 44100 Hz */
   /* Audio stream is resampled to desired rate using Blip Buffer */
@@ -245,6 +2024,14 @@ int cdd_context_save(uint8 *state)
     if (cdd.toc.tracks[cdd.index].vf.seekable)
     {
       /* VORBIS file sample offset */
+#ifdef USE_OGG_THREAD
+      if (ogg_thread.started && (ogg_thread.index == cdd.index))
+      {
+        /* current playing position (decoding is running ahead) */
+        offset = ogg_thread.offset;
+      }
+      else
+#endif
       offset = ov_pcm_tell(&cdd.toc.tracks[cdd.index].vf);
     }
     else
@@ -252,7 +2039,14 @@ int cdd_context_save(uint8 *state)
     if (cdd.toc.tracks[cdd.index].fd)
     {
       /* PCM file offset */
-      offset = cdStreamTell(cdd.toc.tracks[cdd.index].fd);
+      offset = cdd_track_tell(cdd.index);
+#ifdef USE_CD_CACHE
+      if (cdd_cache_active)
+      {
+        /* source image file offset */
+        offset = cdd_cache_state_offset(cdd.index, offset);
+      }
+#endif
     }
   }
 
@@ -302,6 +2096,9 @@ int cdd_context_load(uint8 *state, char *version)
     /* current track is an audio track ? */
     if (cdd.toc.tracks[index].type == TYPE_AUDIO)
     {
+      /* stop any background VORBIS decoding */
+      OGG_THREAD_CANCEL();
+
 #if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
 #ifdef DISABLE_MANY_OGG_OPEN_FILES
       /* check if track index has changed */
@@ -335,13 +2132,26 @@ int cdd_context_load(uint8 *state, char *version)
       {
         /* VORBIS file sample offset */
         ov_pcm_seek(&cdd.toc.tracks[index].vf, offset);
+#ifdef USE_OGG_THREAD
+        if (cdd.toc.tracks[index].vf.datasource)
+        {
+          ogg_thread_play(index);
+        }
+#endif
       }
       else
 #endif 
       if (cdd.toc.tracks[index].fd)
       {
         /* PCM file offset */
-        cdStreamSeek(cdd.toc.tracks[index].fd, offset, SEEK_SET);
+#ifdef USE_CD_CACHE
+        if (cdd_cache_active)
+        {
+          /* source image file offset */
+          offset = cdd_cache_file_offset(index, offset);
+        }
+#endif
+        cdd_track_seek(index, offset);
       }
     }
   }
@@ -374,7 +2184,7 @@ int cdd_load(char *filename, char *header)
   cdd_unload();
 
   /* open file */
-  fd = cdStreamOpen(filename);
+  fd = cdd_stream_open(filename);
   if (!fd)
   {
     /* do not return an error as this could be a ROM loaded in memory */
@@ -385,7 +2195,7 @@ int cdd_load(char *filename, char *header)
 #if defined(USE_LIBCHDR)
   if (!memcmp("chd", &filename[strlen(filename) - 3], 3) || !memcmp("CHD", &filename[strlen(filename) - 3], 3))
   {
-    int sectors = 0;
+    int i, sectors = 0;
     char metadata[256];
     const chd_header *head;
 
@@ -408,9 +2218,9 @@ int cdd_load(char *filename, char *header)
       return -1;
     }
 
-    /* allocate hunk buffer */
-    cdd.chd.hunk = (uint8 *)malloc(head->hunkbytes);
-    if (!cdd.chd.hunk)
+    /* allocate hunks cache */
+    cdd.chd.cache = (uint8 *)malloc(head->hunkbytes * CHD_CACHE_SIZE);
+    if (!cdd.chd.cache)
     {
       chd_close(cdd.chd.file);
       cdStreamClose(fd);
@@ -419,10 +2229,21 @@ int cdd_load(char *filename, char *header)
 
     /* initialize hunk size (usually fixed to 8 sectors) */
     cdd.chd.hunkbytes = head->hunkbytes;
+    cdd.chd.hunks = head->totalhunks;
 
     /* initialize buffered hunk index */
     cdd.chd.hunknum = -1;
 
+    /* initialize hunks cache */
+    for (i=0; i<CHD_CACHE_SIZE; i++)
+    {
+      cdd.chd.cachenum[i] = -1;
+      cdd.chd.cacheage[i] = 0;
+    }
+    cdd.chd.age = 0;
+    cdd.chd.slot = -1;
+    cdd.chd.hunk = cdd.chd.cache;
+
     /* retrieve tracks informations */
     for (cdd.toc.last = 0; cdd.toc.last < 99; cdd.toc.last++)
     {
@@ -516,8 +2337,7 @@ int cdd_load(char *filename, char *header)
     if (cdd.sectorSize)
     {
       /* read first chunk of data */
-      cdd.chd.hunknum = cdd.toc.tracks[0].offset / cdd.chd.hunkbytes;
-      chd_read(cdd.chd.file, cdd.chd.hunknum, cdd.chd.hunk);
+      cdd_chd_read(cdd.toc.tracks[0].offset / cdd.chd.hunkbytes);
 
       /* copy CD image header + security code (skip RAW sector 16-byte header) */
       memcpy(header, cdd.chd.hunk + (cdd.toc.tracks[0].offset % cdd.chd.hunkbytes) + ((cdd.sectorSize == 2048) ? 0 : 16), 0x210);
@@ -531,10 +2351,19 @@ int cdd_load(char *filename, char *header)
 
       /* CD mounted */
       cdd.loaded = HW_ADDON_MEGACD;
+
+#ifdef USE_CD_CACHE
+      /* use (or create) decoded image file in cache directory */
+      cdd_cache_update(filename, header);
+#endif
       return 1;
     }
 
     /* invalid CHD file */
+#ifdef USE_CHD_THREAD
+    cdd_chd_thread_stop();
+#endif
+    free(cdd.chd.cache);
     chd_close(cdd.chd.file);
     cdStreamClose(fd);
     return -1;
@@ -685,7 +2514,7 @@ int cdd_load(char *filename, char *header)
         *ptr = 0;
 
         /* open current track file descriptor */
-        cdd.toc.tracks[cdd.toc.last].fd = cdStreamOpen(fname);
+        cdd.toc.tracks[cdd.toc.last].fd = cdd_stream_open(fname);
         if (!cdd.toc.tracks[cdd.toc.last].fd)
         {
           /* error opening file */
@@ -977,7 +2806,7 @@ int cdd_load(char *filename, char *header)
     {
       /* auto-detect wrong initial track index */
       sprintf(ptr, extensions[i], cdd.toc.last);
-      fd = cdStreamOpen(fname);
+      fd = cdd_stream_open(fname);
       if (fd)
       {
         offset = 0;
@@ -985,7 +2814,7 @@ int cdd_load(char *filename, char *header)
       }
 
       sprintf(ptr, extensions[i], cdd.toc.last + 1);
-      fd = cdStreamOpen(fname);
+      fd = cdd_stream_open(fname);
       if (fd) break;
     }
 
@@ -1134,7 +2963,7 @@ int cdd_load(char *filename, char *header)
 
       /* try to open next audio track file */
       sprintf(ptr, extensions[i], cdd.toc.last + offset);
-      fd = cdStreamOpen(fname);
+      fd = cdd_stream_open(fname);
     }
 
     /* Valid CD-ROM Mode 1 track found ? */
@@ -1253,9 +3082,19 @@ int cdd_load(char *filename, char *header)
     /* CD mounted */
     cdd.loaded = isMSDfile ? HW_ADDON_MEGASD : HW_ADDON_MEGACD;
 
+#ifdef USE_CD_MMAP
+    /* map track files in memory when possible */
+    cdd_map_tracks();
+#endif
+
     /* Automatically try to open associated subcode data file */
     memcpy(&fname[strlen(fname) - 4], ".sub", 4);
-    cdd.toc.sub = cdStreamOpen(fname);
+    cdd.toc.sub = cdd_stream_open(fname);
+
+#ifdef USE_CD_CACHE
+    /* use (or create) decoded image file in cache directory */
+    cdd_cache_update(filename, header);
+#endif
 
     /* return 1 if loaded file is CD image file */
     return (isCDfile);
@@ -1267,14 +3106,27 @@ int cdd_load(char *filename, char *header)
 
 void cdd_unload(void)
 {
+#ifdef USE_CD_CACHE
+  /* stop cache file creation */
+  cdd_cache_stop();
+#endif
+
   if (cdd.loaded)
   {
     int i;
 
 #if defined(USE_LIBCHDR)
+#ifdef USE_CHD_THREAD
+    cdd_chd_thread_stop();
+#endif
     chd_close(cdd.chd.file);
-    if (cdd.chd.hunk)
-      free(cdd.chd.hunk);
+    if (cdd.chd.cache)
+      free(cdd.chd.cache);
+#endif
+
+#ifdef USE_OGG_THREAD
+    /* stop background VORBIS decoding */
+    ogg_thread_stop();
 #endif
 
     /* close CD tracks */
@@ -1312,6 +3164,19 @@ void cdd_unload(void)
     cdd.loaded = 0;
   }
 
+#ifdef USE_CD_MMAP
+  /* unmap track files */
+  cdd_unmap_tracks();
+#endif
+
+#if defined(USE_CD_MMAP) || defined(USE_CD_CACHE)
+  cdd_file_count = 0;
+#endif
+
+#ifdef USE_CD_CACHE
+  cdd_cache_active = 0;
+#endif
+
   /* reset TOC */
   memset(&cdd.toc, 0x00, sizeof(cdd.toc));
 
@@ -1341,8 +3206,7 @@ void cdd_read_data(uint8 *dst, uint8 *subheader)
       /* update CHD hunk cache if necessary */
       if (hunknum != cdd.chd.hunknum)
       {
-        chd_read(cdd.chd.file, hunknum, cdd.chd.hunk);
-        cdd.chd.hunknum = hunknum;
+        cdd_chd_read(hunknum);
       }
 
       /* check sector size */
@@ -1377,8 +3241,8 @@ void cdd_read_data(uint8 *dst, uint8 *subheader)
     if (cdd.sectorSize == 2048)
     {
       /* read Mode 1 user data (2048 bytes) */
-      cdStreamSeek(cdd.toc.tracks[0].fd, cdd.lba * 2048, SEEK_SET);
-      cdStreamRead(dst, 2048, 1, cdd.toc.tracks[0].fd);
+      cdd_track_seek(0, cdd.lba * 2048);
+      cdd_track_read(0, dst, 2048);
     }
     else
     {
@@ -1386,17 +3250,17 @@ void cdd_read_data(uint8 *dst, uint8 *subheader)
       if (!subheader)
       {
         /* skip block sync pattern (12 bytes) + block header (4 bytes) then read Mode 1 user data (2048 bytes) */
-        cdStreamSeek(cdd.toc.tracks[0].fd, (cdd.lba * 2352) + 12 + 4, SEEK_SET);
-        cdStreamRead(dst, 2048, 1, cdd.toc.tracks[0].fd);
+        cdd_track_seek(0, (cdd.lba * 2352) + 12 + 4);
+        cdd_track_read(0, dst, 2048);
       }
       else
       {
         /* skip block sync pattern (12 bytes) + block header (4 bytes) + Mode 2 sub-header (first 4 bytes) then read Mode 2 sub-header (last 4 bytes) */
-        cdStreamSeek(cdd.toc.tracks[0].fd, (cdd.lba * 2352) + 12 + 4 + 4, SEEK_SET);
-        cdStreamRead(subheader, 4, 1, cdd.toc.tracks[0].fd);
+        cdd_track_seek(0, (cdd.lba * 2352) + 12 + 4 + 4);
+        cdd_track_read(0, subheader, 4);
 
         /* read Mode 2 user data (max 2328 bytes) */
-        cdStreamRead(dst, 2328, 1, cdd.toc.tracks[0].fd);
+        cdd_track_read(0, dst, 2328);
       }
     }
   }
@@ -1404,6 +3268,9 @@ void cdd_read_data(uint8 *dst, uint8 *subheader)
 
 void cdd_seek_audio(int index, int lba)
 {
+  /* stop any background VORBIS decoding */
+  OGG_THREAD_CANCEL();
+
 #if defined(USE_LIBTREMOR) || defined(USE_LIBVORBIS)
 #ifdef DISABLE_MANY_OGG_OPEN_FILES
   /* check if track index has changed */
@@ -1438,26 +3305,101 @@ void cdd_seek_audio(int index, int lba)
   {
     /* VORBIS AUDIO track */
     ov_pcm_seek(&cdd.toc.tracks[index].vf, (lba * 588) - cdd.toc.tracks[index].offset);
+#ifdef USE_OGG_THREAD
+    if (cdd.toc.tracks[index].vf.datasource)
+    {
+      ogg_thread_play(index);
+    }
+#endif
   }
   else
 #endif 
   if (cdd.toc.tracks[index].fd)
   {
     /* PCM AUDIO track */
-    cdStreamSeek(cdd.toc.tracks[index].fd, (lba * 2352) - cdd.toc.tracks[index].offset, SEEK_SET);
+    cdd_track_seek(index, (lba * 2352) - cdd.toc.tracks[index].offset);
+  }
+}
+
+/* CD-DA samples block (host-endian 16-bit stereo) */
+static int16 cdd_mix_in[CDD_MIX_SIZE * 2];
+
+/* CD-DA outputs block (interleaved left & right channels) */
+static int cdd_mix_out[CDD_MIX_SIZE * 2];
+
+static void cdd_mix_audio(const int16 *in, int time, int count, int *curVol, int endVol, int *prev)
+{
+  int i, n, mul;
+  int vol = *curVol;
+
+  /* CD-DA output mixing volume (0-100%) */
+  int volume = config.cdda_volume;
+
+  while (count > 0)
+  {
+    int *out = cdd_mix_out;
+
+    n = (count < CDD_MIX_SIZE) ? count : CDD_MIX_SIZE;
+
+    /* apply CD-DA fader ramp (one step/sample) */
+    for (i=0; (i<n) && (vol != endVol); i++)
+    {
+      /* CD-DA fader multiplier (cf. LC7883 datasheet) */
+      /* (MIN) 0,1,2,3,4,8,12,16,20...,1020,1024 (MAX) */
+      mul = (vol & 0x7fc) ? (vol & 0x7fc) : (vol & 0x03);
+
+      /* left & right channels */
+      out[i*2]   = (((in[i*2]   * mul) / 1024) * volume) / 100;
+      out[i*2+1] = (((in[i*2+1] * mul) / 1024) * volume) / 100;
+
+      /* fade-in or fade-out */
+      vol += (vol < endVol) ? 1 : -1;
+    }
+
+    /* apply constant CD-DA fader & mixing volumes to remaining samples (vectorizable) */
+    if (i < n)
+    {
+      int j;
+      mul = (vol & 0x7fc) ? (vol & 0x7fc) : (vol & 0x03);
+
+      if ((mul == 1024) && (volume == 100))
+      {
+        for (j=i*2; j<n*2; j++)
+        {
+          out[j] = in[j];
+        }
+      }
+      else
+      {
+        for (j=i*2; j<n*2; j++)
+        {
+          out[j] = (((in[j] * mul) / 1024) * volume) / 100;
+        }
+      }
+    }
+
+    /* update blip buffer */
+    blip_add_levels_fast(snd.blips[2], time, n, out, prev);
+
+    in += n * 2;
+    time += n;
+    count -= n;
   }
+
+  *curVol = vol;
 }
 
 void cdd_read_audio(unsigned int samples)
 {
   /* previous audio outputs */
-  int prev_l = cdd.audio[0];
-  int prev_r = cdd.audio[1];
+  int prev[2];
+  prev[0] = cdd.audio[0];
+  prev[1] = cdd.audio[1];
 
   /* audio track playing ? */
   if (!scd.regs[0x36>>1].byte.h && cdd.toc.tracks[cdd.index].fd)
   {
-    int i, mul, l, r;
+    int i, n, count;
 
     /* current CD-DA fader volume */
     int curVol = cdd.fader[0];
@@ -1497,86 +3439,23 @@ void cdd_read_audio(unsigned int samples)
       return;
     }
 
+    /* number of samples output before audio is muted (remaining samples are skipped) */
+    count = samples;
+    if (!endVol && (curVol < count))
+    {
+      count = curVol + 1;
+    }
+
     /* read samples from current block */
 #if defined(USE_LIBCHDR)
     if (cdd.chd.file)
     {
-#ifndef LSB_FIRST
-      int16 *ptr = (int16 *) (cdd.chd.hunk + (cdd.chd.hunkofs % cdd.chd.hunkbytes));
-#else
-      uint8 *ptr = cdd.chd.hunk + (cdd.chd.hunkofs % cdd.chd.hunkbytes);
-#endif
-
       /* process 16-bit (big-endian) stereo samples */
-      for (i=0; i<samples; i++)
+      for (i=0; i<count; i+=n)
       {
-        /* CHD hunk index */
-        int hunknum = cdd.chd.hunkofs / cdd.chd.hunkbytes;
-
-        /* update CHD hunk cache if necessary */
-        if (hunknum != cdd.chd.hunknum)
-        {
-          chd_read(cdd.chd.file, hunknum, cdd.chd.hunk);
-          cdd.chd.hunknum = hunknum;
-        }
-
-        /* CD-DA fader multiplier (cf. LC7883 datasheet) */
-        /* (MIN) 0,1,2,3,4,8,12,16,20...,1020,1024 (MAX) */
-        mul = (curVol & 0x7fc) ? (curVol & 0x7fc) : (curVol & 0x03);
-
-        /* left & right channels */
-#ifndef LSB_FIRST
-        l = ((ptr[0] * mul) / 1024);
-        r = ((ptr[1] * mul) / 1024);
-        ptr+=2;
-#else
-        l = (((int16)((ptr[1] + ptr[0]*256)) * mul) / 1024);
-        r = (((int16)((ptr[3] + ptr[2]*256)) * mul) / 1024);
-        ptr+=4;
-#endif
-
-        /* CD-DA output mixing volume (0-100%) */
-        l = (l * config.cdda_volume) / 100;
-        r = (r * config.cdda_volume) / 100;
-
-        /* update blip buffer */
-        blip_add_delta_fast(snd.blips[2], i, l-prev_l, r-prev_r);
-        prev_l = l;
-        prev_r = r;
-
-        /* update CHD file offset */
-        cdd.chd.hunkofs += 4;
-
-        /* detect end of sector data (2352 bytes) */
-        if ((cdd.chd.hunkofs % CD_FRAME_SIZE) == CD_MAX_SECTOR_DATA)
-        {
-          /* skip subcode data (96 bytes) */
-          cdd.chd.hunkofs += CD_MAX_SUBCODE_DATA;
-
-          /* reinitialize hunk cache pointer */
-#ifndef LSB_FIRST
-          ptr = (int16 *) (cdd.chd.hunk + (cdd.chd.hunkofs % cdd.chd.hunkbytes));
-#else
-          ptr = cdd.chd.hunk + (cdd.chd.hunkofs % cdd.chd.hunkbytes);
-#endif
-        }
-
-        /* update CD-DA fader volume (one step/sample) */
-        if (curVol < endVol)
-        {
-          /* fade-in */
-          curVol++;
-        }
-        else if (curVol > endVol)
-        {
-          /* fade-out */
-          curVol--;
-        }
-        else if (!curVol)
-        {
-          /* audio will remain muted until next setup */
-          break;
-        }
+        n = ((count - i) < CDD_MIX_SIZE) ? (count - i) : CDD_MIX_SIZE;
+        cdd_chd_read_audio(cdd_mix_in, n);
+        cdd_mix_audio(cdd_mix_in, i, n, &curVol, endVol, prev);
       }
     }
     else
@@ -1585,8 +3464,20 @@ void cdd_read_audio(unsigned int samples)
     if (cdd.toc.tracks[cdd.index].vf.datasource)
     {
       int len, done = 0;
-      int16 *ptr = (int16 *) (cdc.ram);
       samples = samples * 4;
+#ifdef USE_OGG_THREAD
+      if (ogg_thread.started && (ogg_thread.index == cdd.index))
+      {
+        /* read samples decoded ahead by worker thread */
+        done = ogg_thread_read(cdc.ram, samples);
+
+        /* end of track or decoding error */
+        if (done < samples)
+        {
+          done = samples;
+        }
+      }
+#endif
       while (done < samples)
       {
 #ifdef USE_LIBVORBIS
@@ -1604,114 +3495,45 @@ void cdd_read_audio(unsigned int samples)
       samples = done / 4;
 
       /* process 16-bit (host-endian) stereo samples */
-      for (i=0; i<samples; i++)
-      {
-        /* CD-DA fader multiplier (cf. LC7883 datasheet) */
-        /* (MIN) 0,1,2,3,4,8,12,16,20...,1020,1024 (MAX) */
-        mul = (curVol & 0x7fc) ? (curVol & 0x7fc) : (curVol & 0x03);
-
-        /* left & right channels */
-        l = ((ptr[0] * mul) / 1024);
-        r = ((ptr[1] * mul) / 1024);
-
-        /* CD-DA output mixing volume (0-100%) */
-        l = (l * config.cdda_volume) / 100;
-        r = (r * config.cdda_volume) / 100;
-
-        /* update blip buffer */
-        blip_add_delta_fast(snd.blips[2], i, l-prev_l, r-prev_r);
-        prev_l = l;
-        prev_r = r;
-        ptr+=2;
-
-        /* update CD-DA fader volume (one step/sample) */
-        if (curVol < endVol)
-        {
-          /* fade-in */
-          curVol++;
-        }
-        else if (curVol > endVol)
-        {
-          /* fade-out */
-          curVol--;
-        }
-        else if (!curVol)
-        {
-          /* audio will remain muted until next setup */
-          break;
-        }
-      }
+      cdd_mix_audio((int16 *) (cdc.ram), 0, count, &curVol, endVol, prev);
     }
     else
 #endif
     {
-#ifdef LSB_FIRST
-      int16 *ptr = (int16 *) (cdc.ram);
-#else
-      uint8 *ptr = cdc.ram;
-#endif
-      cdStreamRead(cdc.ram, 1, samples * 4, cdd.toc.tracks[cdd.index].fd);
+      cdd_track_read(cdd.index, cdc.ram, samples * 4);
 
       /* process 16-bit (little-endian) stereo samples */
-      for (i=0; i<samples; i++)
-      {
-        /* CD-DA fader multiplier (cf. LC7883 datasheet) */
-        /* (MIN) 0,1,2,3,4,8,12,16,20...,1020,1024 (MAX) */
-        mul = (curVol & 0x7fc) ? (curVol & 0x7fc) : (curVol & 0x03);
-
-        /* left & right channels */
 #ifdef LSB_FIRST
-        l = ((ptr[0] * mul) / 1024);
-        r = ((ptr[1] * mul) / 1024);
-        ptr+=2;
+      cdd_mix_audio((int16 *) (cdc.ram), 0, count, &curVol, endVol, prev);
 #else
-        l = (((int16)((ptr[0] + ptr[1]*256)) * mul) / 1024);
-        r = (((int16)((ptr[2] + ptr[3]*256)) * mul) / 1024);
-        ptr+=4;
-#endif
-
-        /* CD-DA output mixing volume (0-100%) */
-        l = (l * config.cdda_volume) / 100;
-        r = (r * config.cdda_volume) / 100;
-
-        /* update blip buffer */
-        blip_add_delta_fast(snd.blips[2], i, l-prev_l, r-prev_r);
-        prev_l = l;
-        prev_r = r;
-
-        /* update CD-DA fader volume (one step/sample) */
-        if (curVol < endVol)
-        {
-          /* fade-in */
-          curVol++;
-        }
-        else if (curVol > endVol)
-        {
-          /* fade-out */
-          curVol--;
-        }
-        else if (!curVol)
+      for (i=0; i<count; i+=n)
+      {
+        int j;
+        uint8 *src = cdc.ram + (i * 4);
+        n = ((count - i) < CDD_MIX_SIZE) ? (count - i) : CDD_MIX_SIZE;
+        for (j=0; j<n*2; j++)
         {
-          /* audio will remain muted until next setup */
-          break;
+          cdd_mix_in[j] = (int16)(src[j*2] | (src[j*2+1] << 8));
         }
+        cdd_mix_audio(cdd_mix_in, i, n, &curVol, endVol, prev);
       }
+#endif
     }
 
     /* save current CD-DA fader volume */
     cdd.fader[0] = curVol;
 
     /* save last audio output for next frame */
-    cdd.audio[0] = prev_l;
-    cdd.audio[1] = prev_r;
+    cdd.audio[0] = prev[0];
+    cdd.audio[1] = prev[1];
   }
   else
   {
     /* no audio output */
-    if (prev_l | prev_r)
+    if (prev[0] | prev[1])
     {
       /* update blip buffer */
-      blip_add_delta_fast(snd.blips[2], 0, -prev_l, -prev_r);
+      blip_add_delta_fast(snd.blips[2], 0, -prev[0], -prev[1]);
 
       /* save audio output for next frame */
       cdd.audio[0] = 0;
@@ -1725,6 +3547,8 @@ void cdd_read_audio(unsigned int samples)
 
 void cdd_update_audio(unsigned int samples)
 {
+  PROFILER_ENTER(PROF_CDDA);
+
   /* get number of internal clocks (CD-DA samples) needed */
   samples = blip_clocks_needed(snd.blips[2], samples);
 
@@ -1738,6 +3562,8 @@ void cdd_update_audio(unsigned int samples)
     /* read needed CD-DA samples */
     cdd_read_audio(samples);
   }
+
+  PROFILER_LEAVE();
 }
 
 static void cdd_read_subcode(void)
@@ -2151,6 +3977,14 @@ void cdd_process(void)
         cdd_seek_audio(index, lba);
       }
 
+#if defined(USE_LIBCHDR)
+      /* prefetch CHD hunks from new position */
+      if (cdd.chd.file)
+      {
+        cdd_chd_prefetch((cdd.toc.tracks[index].offset + (lba * CD_FRAME_SIZE)) / cdd.chd.hunkbytes);
+      }
+#endif
+
       /* update current track index */
       cdd.index = index;
 
@@ -2218,6 +4052,14 @@ void cdd_process(void)
         cdd_seek_audio(index, lba);
       }
 
+#if defined(USE_LIBCHDR)
+      /* prefetch CHD hunks from new position */
+      if (cdd.chd.file)
+      {
+        cdd_chd_prefetch((cdd.toc.tracks[index].offset + (lba * CD_FRAME_SIZE)) / cdd.chd.hunkbytes);
+      }
+#endif
+
       /* update current track index */
       cdd.index = index;
 
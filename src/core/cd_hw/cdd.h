@@ -100,14 +100,23 @@ typedef struct
 } toc_t; 
 
 #if defined(USE_LIBCHDR)
+/* number of decompressed CHD hunks kept in cache */
+#define CHD_CACHE_SIZE 16
+
 /* CHD file */
 typedef struct
 {
   chd_file *file;
-  uint8 *hunk;
+  uint8 *hunk;                            /* current hunk data (in cache) */
   int hunkbytes;
   int hunknum;
   int hunkofs;
+  int hunks;                              /* total number of hunks */
+  uint8 *cache;                           /* decompressed hunks cache */
+  int cachenum[CHD_CACHE_SIZE];           /* cached hunk indexes (-1 if unused) */
+  unsigned int cacheage[CHD_CACHE_SIZE];  /* cached hunks last access */
+  unsigned int age;
+  int slot;                               /* current hunk cache index */
 } chd_t;
 #endif
 
@@ -132,7 +141,7 @@ typedef struct
 } cdd_t; 
 
 /* Function prototypes */
-extern void cdd_init(int samplerate);
+extern void cdd_init(double samplerate);
 extern void cdd_reset(void);
 extern int cdd_context_save(uint8 *state);
 extern int cdd_context_load(uint8 *state, char *version);
@@ -44,9 +44,12 @@ extern int8 reset_do_not_clear_buffers;
 
 #define PCM_SCYCLES_RATIO (384 * 4)
 
+/* maximal number of samples mixed at once */
+#define PCM_MIX_SIZE 512
+
 #define pcm scd.pcm_hw
 
-void pcm_init(double clock, int samplerate)
+void pcm_init(double clock, double samplerate)
 {
   /* PCM chip is running at original rate and is synchronized with SUB-CPU  */
   /* Chip output is resampled to desired rate using Blip Buffer. */
@@ -175,77 +178,124 @@ void pcm_run(unsigned int length)
     return;
   }
 
+  PROFILER_ENTER(PROF_PCM);
+
   /* check if PCM chip is running */
   if (pcm.enabled)
   {
-    int i, j, l, r;
-  
-    /* generate PCM samples */
-    for (i=0; i<length; i++)
+    int i, j, l, r, count;
+    int out_l[PCM_MIX_SIZE];
+    int out_r[PCM_MIX_SIZE];
+    unsigned int time = 0;
+
+    /* generate PCM samples by blocks */
+    while (length > time)
     {
-      /* clear output */
-      l = r = 0;
+      count = length - time;
+      if (count > PCM_MIX_SIZE)
+      {
+        count = PCM_MIX_SIZE;
+      }
+
+      /* clear outputs */
+      memset(out_l, 0, count * sizeof(int));
+      memset(out_r, 0, count * sizeof(int));
 
-      /* run eight PCM channels */
+      /* run eight PCM channels one after the other */
       for (j=0; j<8; j++)
       {
         /* check if channel is enabled */
         if (pcm.status & (1 << j))
         {
-          /* read from current WAVE RAM address */
-          short data = pcm.ram[(pcm.chan[j].addr >> 11) & 0xffff];
+          /* channel state is kept in local variables */
+          uint32 addr = pcm.chan[j].addr;
+          uint32 fd = pcm.chan[j].fd.w;
+          uint32 ls = pcm.chan[j].ls.w;
 
-          /* loop data ? */
-          if (data == 0xff)
-          {
-            /* reset WAVE RAM address */
-            pcm.chan[j].addr = pcm.chan[j].ls.w << 11;
+          /* ENV & stereo PAN multipliers */
+          int mul_l = pcm.chan[j].env * (pcm.chan[j].pan & 0x0F);
+          int mul_r = pcm.chan[j].env * (pcm.chan[j].pan >> 4);
 
-            /* read again from WAVE RAM address */
-            data = pcm.ram[pcm.chan[j].ls.w];
-          }
-          else
+          /* muted channel: only update WAVE RAM address */
+          if (!(mul_l | mul_r))
           {
-            /* increment WAVE RAM address */
-            pcm.chan[j].addr += pcm.chan[j].fd.w;
-          }
-
-          /* infinite loop should not output any data */
-          if (data != 0xff)
-          {
-            /* check sign bit (output centered around 0) */
-            if (data & 0x80)
+            for (i=0; i<count; i++)
             {
-              /* PCM data is positive */
-              data = data & 0x7f;
+              if (pcm.ram[(addr >> 11) & 0xffff] == 0xff)
+              {
+                addr = ls << 11;
+              }
+              else
+              {
+                addr += fd;
+              }
             }
-            else
+          }
+          else
+          {
+            for (i=0; i<count; i++)
             {
-              /* PCM data is negative */
-              data = -(data & 0x7f);
+              /* read from current WAVE RAM address */
+              int data = pcm.ram[(addr >> 11) & 0xffff];
+
+              /* loop data ? */
+              if (data == 0xff)
+              {
+                /* reset WAVE RAM address */
+                addr = ls << 11;
+
+                /* read again from WAVE RAM address */
+                data = pcm.ram[ls];
+
+                /* infinite loop should not output any data */
+                if (data == 0xff) continue;
+              }
+              else
+              {
+                /* increment WAVE RAM address */
+                addr += fd;
+              }
+
+              /* check sign bit (output centered around 0) */
+              data = (data & 0x80) ? (data & 0x7f) : -(data & 0x7f);
+
+              /* multiply PCM data with ENV & stereo PAN data then add to L/R outputs (14.5 fixed point) */
+              out_l[i] += ((data * mul_l) >> 5);
+              out_r[i] += ((data * mul_r) >> 5);
             }
-
-            /* multiply PCM data with ENV & stereo PAN data then add to L/R outputs (14.5 fixed point) */
-            l += ((data * pcm.chan[j].env * (pcm.chan[j].pan & 0x0F)) >> 5);
-            r += ((data * pcm.chan[j].env * (pcm.chan[j].pan >> 4)) >> 5);
           }
+
+          /* save WAVE RAM address */
+          pcm.chan[j].addr = addr;
         }
       }
 
-      /* limiter */
-      if (l < -32768) l = -32768;
-      else if (l > 32767) l = 32767;
-      if (r < -32768) r = -32768;
-      else if (r > 32767) r = 32767;
+      /* mix channels outputs */
+      for (i=0; i<count; i++)
+      {
+        l = out_l[i];
+        r = out_r[i];
+
+        /* limiter */
+        if (l < -32768) l = -32768;
+        else if (l > 32767) l = 32767;
+        if (r < -32768) r = -32768;
+        else if (r > 32767) r = 32767;
+
+        /* PCM output mixing level (0-100%) */
+        l = (l * config.pcm_volume) / 100;
+        r = (r * config.pcm_volume) / 100;
 
-      /* PCM output mixing level (0-100%) */
-      l = (l * config.pcm_volume) / 100;
-      r = (r * config.pcm_volume) / 100;
+        /* update blip buffer (if output has changed) */
+        if ((l != prev_l) || (r != prev_r))
+        {
+          blip_add_delta_fast(snd.blips[1], time + i, l-prev_l, r-prev_r);
+          prev_l = l;
+          prev_r = r;
+        }
+      }
 
-      /* update blip buffer */
-      blip_add_delta_fast(snd.blips[1], i, l-prev_l, r-prev_r);
-      prev_l = l;
-      prev_r = r;
+      time += count;
     }
 
     /* save last audio outputs */
@@ -268,6 +318,8 @@ void pcm_run(unsigned int length)
 
   /* update PCM master clock counter */
   pcm.cycles += length * PCM_SCYCLES_RATIO;
+
+  PROFILER_LEAVE();
 }
 
 void pcm_update(unsigned int samples)
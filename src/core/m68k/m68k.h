@@ -286,6 +286,11 @@ typedef struct
 extern m68ki_cpu_core m68k;
 extern m68ki_cpu_core s68k;
 
+#if defined(ENABLE_M68K_SKIP_IDLE_LOOPS) && defined(ENABLE_M68K_CHECK_IDLE_LOOPS)
+/* Number of main 68k idle loops whose executed state did not match skipped loop state */
+extern unsigned int m68k_idle_loop_errors;
+#endif
+
 
 /* ======================================================================== */
 /* ============================== CALLBACKS =============================== */
@@ -72,6 +72,31 @@
  */
 #define M68K_CHECK_PC_ADDRESS_ERROR OPT_OFF
 
+/* If ON, short loops ended by a backward BRA or Bcc instruction and only
+ * reading memory without side effect (e.g. waiting for an interrupt to modify
+ * a flag in RAM) are detected and skipped until the end of current execution
+ * frame. Skipped iterations are exactly accounted so that CPU state and cycle
+ * count end up the same as when executing the loop instruction by instruction.
+ * NOTE: this is disabled by default, as main 68k timing then relies on loop
+ * analysis being correct for every game (see M68K_CHECK_IDLE_LOOPS below).
+ */
+#ifdef ENABLE_M68K_SKIP_IDLE_LOOPS
+#define M68K_SKIP_IDLE_LOOPS        OPT_ON
+#else
+#define M68K_SKIP_IDLE_LOOPS        OPT_OFF
+#endif
+
+/* If ON and previous option is also ON, detected idle loops are not skipped but
+ * still executed instruction by instruction, and CPU state and cycle count are
+ * compared with the ones computed for skipped loop, once loop execution reaches
+ * the point where skipping would have ended.
+ */
+#ifdef ENABLE_M68K_CHECK_IDLE_LOOPS
+#define M68K_CHECK_IDLE_LOOPS       OPT_ON
+#else
+#define M68K_CHECK_IDLE_LOOPS       OPT_OFF
+#endif
+
 
 /* ----------------------------- COMPATIBILITY ---------------------------- */
 
@@ -18,6 +18,7 @@ extern int vdp_68k_irq_ack(int int_level);
 #include "m68kconf.h"
 #include "m68kcpu.h"
 #include "m68kops.h"
+#include "profiler.h"
 
 /* ======================================================================== */
 /* ================================= DATA ================================= */
@@ -29,6 +30,25 @@ static unsigned char m68ki_cycles[0x10000];
 
 static int irq_latency;
 
+#if M68K_SKIP_IDLE_LOOPS
+/* last detected idle loop */
+static cpu_idle_t idle_loop;
+
+#if M68K_CHECK_IDLE_LOOPS
+/* expected CPU state once skipped loop iterations are executed */
+static struct
+{
+  uint pending;
+  uint cycles;
+  uint pc;
+  uint sr;
+  uint dar[16];
+} idle_check;
+
+unsigned int m68k_idle_loop_errors;
+#endif
+#endif
+
 m68ki_cpu_core m68k;
 
 
@@ -72,6 +92,237 @@ static void default_set_fc_callback(unsigned int new_fc)
 #endif
 
 
+/* ======================================================================== */
+/* ============================== IDLE LOOPS ============================== */
+/* ======================================================================== */
+
+#if M68K_SKIP_IDLE_LOOPS
+
+#ifdef M68K_OVERCLOCK_SHIFT
+#define IDLE_CYCLES(A) (((A) * m68ki_cpu.cycle_ratio) >> M68K_OVERCLOCK_SHIFT)
+#else
+#define IDLE_CYCLES(A) (A)
+#endif
+
+/* Called when a backward branch is taken, with PC set to branch target */
+static void m68ki_idle_loop_skip(sint disp)
+{
+  uint ir, size, address;
+  uint pc = REG_PC;
+  uint end = REG_PC - disp - 2;
+  uint body = 0;
+  uint loop, cycles;
+
+  /* only check short loops ended by BRA or Bcc (not BSR or DBcc) instruction */
+  if (((end - pc) > 16) || ((REG_IR & 0xf000) != 0x6000) || ((REG_IR & 0x0f00) == 0x0100))
+  {
+    return;
+  }
+
+  /* loop can not be skipped when executed from m68k_set_irq_delay */
+  if (irq_latency)
+  {
+    return;
+  }
+
+#if M68K_CHECK_IDLE_LOOPS
+  /* previously detected loop is still being executed */
+  if (idle_check.pending)
+  {
+    return;
+  }
+#endif
+
+#ifdef HOOK_CPU
+  /* memory reads must be reported to debugger */
+  if (cpu_hook)
+  {
+    return;
+  }
+#endif
+
+  /* loop body instructions must only modify flags and read memory without side effect */
+  while (pc < end)
+  {
+    ir = m68k_read_immediate_16(pc);
+    pc += 2;
+
+    if (((ir & 0xff00) == 0x4a00) && ((ir & 0xc0) != 0xc0))
+    {
+      /* TST <ea> */
+      size = (ir >> 6) & 3;
+    }
+    else if (((ir & 0xf100) == 0xb000) && ((ir & 0xc0) != 0xc0))
+    {
+      /* CMP <ea>,Dn */
+      size = (ir >> 6) & 3;
+    }
+    else if (((ir & 0xff00) == 0x0c00) && ((ir & 0xc0) != 0xc0))
+    {
+      /* CMPI #<data>,<ea> */
+      size = (ir >> 6) & 3;
+      pc += (size == 2) ? 4 : 2;
+    }
+    else if ((ir & 0xffc0) == 0x0800)
+    {
+      /* BTST #<data>,<ea> */
+      size = 0;
+      pc += 2;
+    }
+    else if ((ir & 0xf1c0) == 0x0100)
+    {
+      /* BTST Dn,<ea> */
+      size = 0;
+    }
+    else
+    {
+      return;
+    }
+
+    /* effective address */
+    switch ((ir >> 3) & 7)
+    {
+      case 0: /* Dn */
+        address = 0;
+        break;
+
+      case 2: /* (An) */
+        address = REG_A[ir & 7];
+        break;
+
+      case 5: /* (d16,An) */
+        address = REG_A[ir & 7] + MAKE_INT_16(m68k_read_immediate_16(pc));
+        pc += 2;
+        break;
+
+      case 7:
+        if ((ir & 7) == 0)
+        {
+          /* (xxx).W */
+          address = MAKE_INT_16(m68k_read_immediate_16(pc));
+          pc += 2;
+          break;
+        }
+        else if ((ir & 7) == 1)
+        {
+          /* (xxx).L */
+          address = m68k_read_immediate_32(pc);
+          pc += 4;
+          break;
+        }
+        return;
+
+      default:
+        return;
+    }
+
+    /* memory read access */
+    if (ir & 0x38)
+    {
+      if (size == 0)
+      {
+        if (m68ki_cpu.memory_map[(address >> 16) & 0xff].read8)
+        {
+          return;
+        }
+      }
+      else if ((address & 1) || m68ki_cpu.memory_map[(address >> 16) & 0xff].read16)
+      {
+        return;
+      }
+      else if ((size == 2) && m68ki_cpu.memory_map[((address + 3) >> 16) & 0xff].read16)
+      {
+        /* long read crossing into next 64KB bank */
+        return;
+      }
+    }
+
+    body += IDLE_CYCLES(CYC_INSTRUCTION[ir]);
+  }
+
+  /* last instruction must end at branch instruction */
+  if (pc != end)
+  {
+    return;
+  }
+
+  /* loop execution cycles, including taken branch instruction */
+  loop = body + IDLE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+
+  /* loop state is only known to be stable once a full iteration has been executed */
+  /* since last detection, without anything else being executed in between        */
+  if (!idle_loop.detected || (idle_loop.pc != end) || (idle_loop.cycle != m68ki_cpu.cycles))
+  {
+    idle_loop.detected = 1;
+    idle_loop.pc = end;
+    idle_loop.cycle = m68ki_cpu.cycles + loop;
+    return;
+  }
+
+  /* CPU cycle count once branch instruction is executed */
+  cycles = m68ki_cpu.cycles + loop - body;
+
+  /* skip all loop iterations that would be fully executed before the end of execution frame */
+  if ((cycles + body) < m68ki_cpu.cycle_end)
+  {
+#if M68K_CHECK_IDLE_LOOPS
+    int i;
+
+    /* loop is executed normally, CPU state is checked once skipped iterations are executed */
+    idle_check.pending = 1;
+    idle_check.cycles = cycles + ((m68ki_cpu.cycle_end - cycles - body + loop - 1) / loop) * loop;
+    idle_check.pc = REG_PC;
+    idle_check.sr = m68ki_get_sr();
+    for (i = 0; i < 16; i++)
+    {
+      idle_check.dar[i] = REG_DA[i];
+    }
+#else
+    m68ki_cpu.cycles += ((m68ki_cpu.cycle_end - cycles - body + loop - 1) / loop) * loop;
+#endif
+  }
+
+  idle_loop.detected = 0;
+}
+
+#if M68K_CHECK_IDLE_LOOPS
+/* Called once executed loop reaches the cycle count computed for skipped loop */
+static void m68ki_idle_loop_check(void)
+{
+  int i;
+  uint match = (m68ki_cpu.cycles == idle_check.cycles) && (REG_PC == idle_check.pc) && (m68ki_get_sr() == idle_check.sr);
+
+  for (i = 0; i < 16; i++)
+  {
+    if (REG_DA[i] != idle_check.dar[i])
+    {
+      match = 0;
+    }
+  }
+
+  if (!match)
+  {
+    m68k_idle_loop_errors++;
+#ifdef LOGERROR
+    error("[%d] m68k idle loop mismatch: cycles %d (%d), pc %x (%x), sr %x (%x)\n", v_counter, m68ki_cpu.cycles, idle_check.cycles, REG_PC, idle_check.pc, m68ki_get_sr(), idle_check.sr);
+#endif
+  }
+
+  idle_check.pending = 0;
+}
+#endif
+
+/* Called when CPU state is modified outside of instruction execution */
+static void m68ki_idle_loop_reset(void)
+{
+  idle_loop.detected = 0;
+#if M68K_CHECK_IDLE_LOOPS
+  idle_check.pending = 0;
+#endif
+}
+
+#endif
+
 /* ======================================================================== */
 /* ================================= API ================================== */
 /* ======================================================================== */
@@ -120,6 +371,11 @@ unsigned int m68k_get_reg(m68k_register_t regnum)
 
 void m68k_set_reg(m68k_register_t regnum, unsigned int value)
 {
+#if M68K_SKIP_IDLE_LOOPS
+  /* restart idle loop detection (loaded state, debugger) */
+  m68ki_idle_loop_reset();
+#endif
+
   switch(regnum)
   {
     case M68K_REG_D0:  REG_D[0] = MASK_OUT_ABOVE_32(value); return;
@@ -272,9 +528,24 @@ void m68k_run(unsigned int cycles)
     return;
   }
 
+  PROFILER_ENTER(PROF_M68K);
+
   /* Save end cycles count for when CPU is stopped */
   m68k.cycle_end = cycles;
 
+#if M68K_SKIP_IDLE_LOOPS
+#if M68K_CHECK_IDLE_LOOPS
+  /* Executed loop must have reached expected state during previous execution frame */
+  if (idle_check.pending)
+  {
+    m68k_idle_loop_errors++;
+  }
+#endif
+
+  /* Idle loop detection is restarted for each execution frame */
+  m68ki_idle_loop_reset();
+#endif
+
   /* Return point for when we have an address error (TODO: use goto) */
   m68ki_set_address_error_trap() /* auto-disable (see m68kcpu.h) */
 
@@ -303,9 +574,19 @@ void m68k_run(unsigned int cycles)
     m68ki_instruction_jump_table[REG_IR]();
     USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
 
+#if M68K_SKIP_IDLE_LOOPS && M68K_CHECK_IDLE_LOOPS
+    /* Check CPU state once skipped loop iterations are executed */
+    if (idle_check.pending && (m68k.cycles >= idle_check.cycles))
+    {
+      m68ki_idle_loop_check();
+    }
+#endif
+
     /* Trace m68k_exception, if necessary */
     m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
   }
+
+  PROFILER_LEAVE();
 }
 
 int m68k_cycles(void)
@@ -362,6 +643,11 @@ void m68k_pulse_reset(void)
   CPU_INT_LEVEL = 0;
   irq_latency = 0;
 
+#if M68K_SKIP_IDLE_LOOPS
+  /* Restart idle loop detection */
+  m68ki_idle_loop_reset();
+#endif
+
   /* Go to supervisor mode */
   m68ki_set_s_flag(SFLAG_SET);
 
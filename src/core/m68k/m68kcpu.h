@@ -744,6 +744,11 @@ INLINE void m68ki_branch_8(uint offset);
 INLINE void m68ki_branch_16(uint offset);
 INLINE void m68ki_branch_32(uint offset);
 
+#if M68K_SKIP_IDLE_LOOPS
+/* Idle loop detection (see m68kcpu.c) */
+static void m68ki_idle_loop_skip(sint disp);
+#endif
+
 /* Status register operations. */
 INLINE void m68ki_set_s_flag(uint value);            /* Only bit 2 of value should be set (i.e. 4 or 0) */
 INLINE void m68ki_set_ccr(uint value);               /* set the condition code register */
@@ -1146,11 +1151,19 @@ INLINE void m68ki_jump_vector(uint vector)
 INLINE void m68ki_branch_8(uint offset)
 {
   REG_PC += MAKE_INT_8(offset);
+#if M68K_SKIP_IDLE_LOOPS
+  if (offset & 0x80)
+    m68ki_idle_loop_skip(MAKE_INT_8(offset));
+#endif
 }
 
 INLINE void m68ki_branch_16(uint offset)
 {
   REG_PC += MAKE_INT_16(offset);
+#if M68K_SKIP_IDLE_LOOPS
+  if (offset & 0x8000)
+    m68ki_idle_loop_skip(MAKE_INT_16(offset));
+#endif
 }
 
 INLINE void m68ki_branch_32(uint offset)
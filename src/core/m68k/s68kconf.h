@@ -76,6 +76,17 @@
  */
 #define M68K_CHECK_PC_ADDRESS_ERROR OPT_OFF
 
+/* If ON, short loops ended by a backward BRA or Bcc instruction and only
+ * reading memory without side effect (e.g. waiting for an interrupt to modify
+ * a flag in RAM) are detected and skipped until the end of current execution
+ * frame. Skipped iterations are exactly accounted so that CPU state and cycle
+ * count end up the same as when executing the loop instruction by instruction.
+ */
+#define M68K_SKIP_IDLE_LOOPS        OPT_OFF
+
+/* Not used (see m68kconf.h) */
+#define M68K_CHECK_IDLE_LOOPS       OPT_OFF
+
 
 /* ----------------------------- COMPATIBILITY ---------------------------- */
 
@@ -18,6 +18,7 @@ extern int scd_68k_irq_ack(int level);
 #include "s68kconf.h"
 #include "m68kcpu.h"
 #include "m68kops.h"
+#include "profiler.h"
 
 /* ======================================================================== */
 /* ================================= DATA ================================= */
@@ -235,6 +236,8 @@ void s68k_run(unsigned int cycles)
     return;
   }
 
+  PROFILER_ENTER(PROF_S68K);
+
   /* Save end cycles count for when CPU is stopped */
   s68k.cycle_end = cycles;
 
@@ -263,6 +266,8 @@ void s68k_run(unsigned int cycles)
     /* Trace m68k_exception, if necessary */
     m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
   }
+
+  PROFILER_LEAVE();
 }
 
 
@@ -53,18 +53,26 @@
 #define ALIGNED_(x) __attribute__ ((aligned(x)))
 #endif
 
-/* Default CD image file access (read-only) functions */
+/* Default CD image file access functions (files are only created by CD image cache) */
 /* If you need to override default stdio.h functions with custom filesystem API,
    redefine following macros in platform specific include file (osd.h) or Makefile
 */
 #ifndef cdStream
 #define cdStream            FILE
 #define cdStreamOpen(fname) fopen(fname, "rb")
+#define cdStreamCreate(fname) fopen(fname, "wb")
 #define cdStreamClose       fclose
 #define cdStreamRead        fread
+#define cdStreamWrite       fwrite
 #define cdStreamSeek        fseek
 #define cdStreamTell        ftell
 #define cdStreamGets        fgets
 #endif
 
+/* Default CD image cache file management functions */
+#ifndef cdCacheRename
+#define cdCacheRename       rename
+#define cdCacheRemove       remove
+#endif
+
 #endif /* _MACROS_H_ */
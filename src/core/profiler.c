@@ -0,0 +1,195 @@
+/***************************************************************************************
+ *  Genesis Plus
+ *  Frame profiler
+ *
+ *  Per-subsystem execution time & call count instrumentation
+ *
+ *  Copyright (C) 2026  Genesis Plus GX contributors
+ *
+ *  Redistribution and use of this code or any derivative works are permitted
+ *  provided that the following conditions are met:
+ *
+ *   - Redistributions may not be sold, nor may they be used in a commercial
+ *     product or activity.
+ *
+ *   - Redistributions that are modified from the original source must include the
+ *     complete source code, including the source code for all components used by a
+ *     binary built from the modified sources. However, as a special exception, the
+ *     source code distributed need not include anything that is normally distributed
+ *     (in either source or binary form) with the major components (compiler, kernel,
+ *     and so on) of the operating system on which the executable runs, unless that
+ *     component itself accompanies the executable.
+ *
+ *   - Redistributions must reproduce the above copyright notice, this list of
+ *     conditions and the following disclaimer in the documentation and/or other
+ *     materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************************/
+
+#if defined(USE_PROFILER) && !defined(_WIN32)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "shared.h"
+
+#ifdef USE_PROFILER
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* maximal nesting of profiled subsystems (FM/PSG updates are run from CPU memory handlers) */
+#define PROF_STACK_SIZE 8
+
+static const char *prof_names[PROF_MAX] =
+{
+  "system", "m68k", "s68k", "z80", "svp", "render", "dma", "fm", "psg", "blip", "pcm", "cdda", "audio"
+};
+
+static t_profile prof_current;
+static t_profile prof_frame;
+static t_profile prof_total;
+
+static int prof_stack[PROF_STACK_SIZE];
+static int prof_depth;
+static unsigned long long prof_mark;
+
+static unsigned long long profiler_time(void)
+{
+#ifdef _WIN32
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER count;
+  if (!freq.QuadPart)
+  {
+    QueryPerformanceFrequency(&freq);
+  }
+  QueryPerformanceCounter(&count);
+  return (unsigned long long)((count.QuadPart * 1000000000.0) / freq.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((unsigned long long)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+#endif
+}
+
+void profiler_reset(void)
+{
+  memset(&prof_current, 0, sizeof(prof_current));
+  memset(&prof_frame, 0, sizeof(prof_frame));
+  memset(&prof_total, 0, sizeof(prof_total));
+  prof_depth = 0;
+}
+
+/* currently running subsystem (nesting levels beyond stack size are accounted to last tracked level) */
+static int profiler_active(void)
+{
+  return prof_stack[((prof_depth < PROF_STACK_SIZE) ? prof_depth : PROF_STACK_SIZE) - 1];
+}
+
+void profiler_enter(int id)
+{
+  unsigned long long now = profiler_time();
+
+  /* interrupted subsystem only gets its own (exclusive) execution time */
+  if (prof_depth)
+  {
+    prof_current.time[profiler_active()] += now - prof_mark;
+  }
+
+  /* nesting depth is always updated so that enter & leave calls stay balanced */
+  if (prof_depth < PROF_STACK_SIZE)
+  {
+    prof_stack[prof_depth] = id;
+  }
+  prof_depth++;
+
+  prof_current.calls[id]++;
+  prof_mark = now;
+}
+
+void profiler_leave(void)
+{
+  unsigned long long now = profiler_time();
+
+  if (prof_depth)
+  {
+    prof_current.time[profiler_active()] += now - prof_mark;
+    prof_depth--;
+  }
+
+  prof_mark = now;
+}
+
+void profiler_frame(void)
+{
+  int i;
+
+  /* last frame statistics */
+  prof_current.frames = 1;
+  prof_frame = prof_current;
+
+  /* accumulated statistics */
+  prof_total.frames++;
+  for (i=0; i<PROF_MAX; i++)
+  {
+    prof_total.time[i] += prof_current.time[i];
+    prof_total.calls[i] += prof_current.calls[i];
+  }
+
+  memset(&prof_current, 0, sizeof(prof_current));
+}
+
+const t_profile *profiler_get_frame(void)
+{
+  return &prof_frame;
+}
+
+const t_profile *profiler_get_total(void)
+{
+  return &prof_total;
+}
+
+const char *profiler_get_name(int id)
+{
+  return ((id >= 0) && (id < PROF_MAX)) ? prof_names[id] : NULL;
+}
+
+void profiler_write_csv_header(FILE *fp)
+{
+  int i;
+
+  fprintf(fp, "frames");
+  for (i=0; i<PROF_MAX; i++)
+  {
+    fprintf(fp, ",%s_ns,%s_calls", prof_names[i], prof_names[i]);
+  }
+  fprintf(fp, "\n");
+}
+
+void profiler_write_csv(FILE *fp, const t_profile *profile)
+{
+  int i;
+
+  fprintf(fp, "%u", profile->frames);
+  for (i=0; i<PROF_MAX; i++)
+  {
+    fprintf(fp, ",%llu,%u", profile->time[i], profile->calls[i]);
+  }
+  fprintf(fp, "\n");
+}
+
+#endif /* USE_PROFILER */
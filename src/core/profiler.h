@@ -0,0 +1,90 @@
+/***************************************************************************************
+ *  Genesis Plus
+ *  Frame profiler
+ *
+ *  Per-subsystem execution time & call count instrumentation
+ *
+ *  Copyright (C) 2026  Genesis Plus GX contributors
+ *
+ *  Redistribution and use of this code or any derivative works are permitted
+ *  provided that the following conditions are met:
+ *
+ *   - Redistributions may not be sold, nor may they be used in a commercial
+ *     product or activity.
+ *
+ *   - Redistributions that are modified from the original source must include the
+ *     complete source code, including the source code for all components used by a
+ *     binary built from the modified sources. However, as a special exception, the
+ *     source code distributed need not include anything that is normally distributed
+ *     (in either source or binary form) with the major components (compiler, kernel,
+ *     and so on) of the operating system on which the executable runs, unless that
+ *     component itself accompanies the executable.
+ *
+ *   - Redistributions must reproduce the above copyright notice, this list of
+ *     conditions and the following disclaimer in the documentation and/or other
+ *     materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************************/
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+/* Profiled subsystems */
+#define PROF_SYSTEM   0   /* frame loop (time not spent in any other subsystem) */
+#define PROF_M68K     1   /* MAIN-CPU */
+#define PROF_S68K     2   /* SUB-CPU (Mega CD) */
+#define PROF_Z80      3   /* Z80 CPU */
+#define PROF_SVP      4   /* SSP1601 DSP */
+#define PROF_RENDER   5   /* VDP line rendering */
+#define PROF_DMA      6   /* VDP DMA */
+#define PROF_FM       7   /* YM2612 / YM3438 / YM2413 synthesis */
+#define PROF_PSG      8   /* PSG synthesis */
+#define PROF_BLIP     9   /* Blip Buffer resampling */
+#define PROF_PCM      10  /* RF5C164 PCM (Mega CD) */
+#define PROF_CDDA     11  /* CD-DA playback (Mega CD) */
+#define PROF_AUDIO    12  /* audio output filters */
+#define PROF_MAX      13
+
+#ifdef USE_PROFILER
+
+typedef struct
+{
+  unsigned int frames;                /* number of frames accumulated */
+  unsigned long long time[PROF_MAX];  /* exclusive execution time (nanoseconds) */
+  unsigned int calls[PROF_MAX];       /* number of calls */
+} t_profile;
+
+/* Function prototypes */
+extern void profiler_reset(void);
+extern void profiler_enter(int id);
+extern void profiler_leave(void);
+extern void profiler_frame(void);
+extern const t_profile *profiler_get_frame(void);
+extern const t_profile *profiler_get_total(void);
+extern const char *profiler_get_name(int id);
+extern void profiler_write_csv_header(FILE *fp);
+extern void profiler_write_csv(FILE *fp, const t_profile *profile);
+
+#define PROFILER_ENTER(id) profiler_enter(id)
+#define PROFILER_LEAVE()   profiler_leave()
+
+#else
+
+#define PROFILER_ENTER(id)
+#define PROFILER_LEAVE()
+
+#endif /* USE_PROFILER */
+
+#endif /* _PROFILER_H_ */
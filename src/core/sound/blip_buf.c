@@ -6,6 +6,7 @@
 /*  - added blip_mix_samples function (see blip_buf.h)              */
 /*  - added stereo buffer support (define #BLIP_MONO to disable)    */
 /*  - added inverted stereo output (define #BLIP_INVERT to enable)*/
+/*  - added SSE2 stereo blip_add_delta (define #BLIP_NO_SIMD to disable) */
 
 #include "blip_buf.h"
 
@@ -16,6 +17,11 @@
 #include <string.h>
 #include <stdlib.h>
 
+#if !defined(BLIP_MONO) && !defined(BLIP_NO_SIMD) && defined(__SSE2__)
+#define BLIP_SSE2
+#include <emmintrin.h>
+#endif
+
 /* Library Copyright (C) 2003-2009 Shay Green. This library is free software;
 you can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -116,6 +122,10 @@ enum { min_sample = -32768 };
     else if ( n < min_sample) n = min_sample;\
 	}
 
+#ifdef BLIP_SSE2
+static void init_kernel( void );
+#endif
+
 #ifdef BLIP_ASSERT
 static void check_assumptions( void )
 {
@@ -169,6 +179,9 @@ blip_t* blip_new( int size )
 		blip_clear( m );
 #ifdef BLIP_ASSERT
 		check_assumptions();
+#endif
+#ifdef BLIP_SSE2
+		init_kernel();
 #endif
   }
 	return m;
@@ -484,6 +497,109 @@ simply ignoring the low half. */
 
 #ifndef BLIP_MONO
 
+#ifdef BLIP_SSE2
+
+/* Step kernel rearranged for _mm_madd_epi16: for each phase, the 16 output taps
+are stored as (in, in + half_width) coefficient pairs, so one 32-bit lane holds
+the two coefficients applied to (delta_l, delta) for the same output sample. */
+static short bl_kernel [phase_count] [half_width * 4];
+
+static void init_kernel( void )
+{
+	int phase, i;
+	for ( phase = 0; phase < phase_count; phase++ )
+	{
+		short const* in  = bl_step [phase];
+		short const* rev = bl_step [phase_count - phase];
+		short* out = bl_kernel [phase];
+		for ( i = 0; i < half_width; i++ )
+		{
+			out [i*2+0] = in [i];
+			out [i*2+1] = in [half_width+i];
+			out [(half_width+i)*2+0] = rev [half_width-1-i];
+			out [(half_width+i)*2+1] = rev [-1-i];
+		}
+	}
+}
+
+/* Multiplies coefficient pairs by (delta_l, delta) 16-bit halves. Deltas are
+split into signed high and unsigned 15-bit low parts so that result is the same
+as 32-bit scalar multiply-accumulate. */
+#define KERNEL_SPLIT( lo, hi, delta_l, delta ) \
+	{\
+		lo = _mm_set1_epi32( (int) ((((unsigned) (delta) & 0x7fff) << 16) | ((unsigned) (delta_l) & 0x7fff)) );\
+		hi = _mm_set1_epi32( (int) ((((unsigned) ARITH_SHIFT( delta, 15 ) & 0xffff) << 16) | ((unsigned) ARITH_SHIFT( delta_l, 15 ) & 0xffff)) );\
+	}
+
+#define KERNEL_MUL( k, lo, hi ) \
+	_mm_add_epi32( _mm_madd_epi16( k, lo ), _mm_slli_epi32( _mm_madd_epi16( k, hi ), 15 ) )
+
+#define KERNEL_ADD( out, n, v ) \
+	_mm_storeu_si128( (__m128i*) ((out) + (n)), _mm_add_epi32( _mm_loadu_si128( (__m128i const*) ((out) + (n)) ), v ) )
+
+void blip_add_delta( blip_t* m, unsigned time, int delta_l, int delta_r )
+{
+  if (delta_l | delta_r)
+  {
+    unsigned fixed = (unsigned) ((time * m->factor + m->offset) >> pre_shift);
+    int phase = fixed >> phase_shift & (phase_count - 1);
+    __m128i const* kernel = (__m128i const*) bl_kernel [phase];
+    int interp = fixed >> (phase_shift - delta_bits) & (delta_unit - 1);
+    int pos = fixed >> frac_bits;
+
+#ifdef BLIP_INVERT
+    buf_t* out_l = m->buffer[1] + pos;
+    buf_t* out_r = m->buffer[0] + pos;
+#else
+    buf_t* out_l = m->buffer[0] + pos;
+    buf_t* out_r = m->buffer[1] + pos;
+#endif
+
+    __m128i k0 = _mm_loadu_si128( kernel + 0 );
+    __m128i k1 = _mm_loadu_si128( kernel + 1 );
+    __m128i k2 = _mm_loadu_si128( kernel + 2 );
+    __m128i k3 = _mm_loadu_si128( kernel + 3 );
+    __m128i lo, hi, v0, v1, v2, v3;
+    int stereo = (delta_l != delta_r);
+    int delta;
+
+#ifdef BLIP_ASSERT
+    /* Fails if buffer size was exceeded */
+    assert( pos <= m->size + end_frame_extra );
+#endif
+
+    delta = (delta_l * interp) >> delta_bits;
+    delta_l -= delta;
+    KERNEL_SPLIT( lo, hi, delta_l, delta );
+    v0 = KERNEL_MUL( k0, lo, hi );
+    v1 = KERNEL_MUL( k1, lo, hi );
+    v2 = KERNEL_MUL( k2, lo, hi );
+    v3 = KERNEL_MUL( k3, lo, hi );
+    KERNEL_ADD( out_l, 0, v0 );
+    KERNEL_ADD( out_l, 4, v1 );
+    KERNEL_ADD( out_l, 8, v2 );
+    KERNEL_ADD( out_l, 12, v3 );
+
+    if (stereo)
+    {
+      delta = (delta_r * interp) >> delta_bits;
+      delta_r -= delta;
+      KERNEL_SPLIT( lo, hi, delta_r, delta );
+      v0 = KERNEL_MUL( k0, lo, hi );
+      v1 = KERNEL_MUL( k1, lo, hi );
+      v2 = KERNEL_MUL( k2, lo, hi );
+      v3 = KERNEL_MUL( k3, lo, hi );
+    }
+
+    KERNEL_ADD( out_r, 0, v0 );
+    KERNEL_ADD( out_r, 4, v1 );
+    KERNEL_ADD( out_r, 8, v2 );
+    KERNEL_ADD( out_r, 12, v3 );
+  }
+}
+
+#else
+
 void blip_add_delta( blip_t* m, unsigned time, int delta_l, int delta_r )
 {
   if (delta_l | delta_r)
@@ -607,6 +723,8 @@ void blip_add_delta( blip_t* m, unsigned time, int delta_l, int delta_r )
   }
 }
 
+#endif /* BLIP_SSE2 */
+
 void blip_add_delta_fast( blip_t* m, unsigned time, int delta_l, int delta_r )
 {
   if (delta_l | delta_r)
@@ -649,6 +767,96 @@ void blip_add_delta_fast( blip_t* m, unsigned time, int delta_l, int delta_r )
   }
 }
 
+void blip_add_levels_fast( blip_t* m, unsigned time, int count, int const levels [], int last [2] )
+{
+  fixed_t t = time * m->factor + m->offset;
+  int prev_l = last[0];
+  int prev_r = last[1];
+
+  /* pending deltas for the two taps at current position (kept in registers since */
+  /* consecutive samples mostly overlap by one tap, initial flush only adds zeroes) */
+  int pos = -2;
+  int acc_l[2] = {0, 0};
+  int acc_r[2] = {0, 0};
+
+#ifdef STEREO_INVERT
+  buf_t* out_l = m->buffer[1] + 7;
+  buf_t* out_r = m->buffer[0] + 7;
+#else
+  buf_t* out_l = m->buffer[0] + 7;
+  buf_t* out_r = m->buffer[1] + 7;
+#endif
+
+  while (count-- > 0)
+  {
+    int delta_l = levels[0] - prev_l;
+    int delta_r = levels[1] - prev_r;
+
+    if (delta_l | delta_r)
+    {
+      unsigned fixed = (unsigned) (t >> pre_shift);
+      int interp = fixed >> (frac_bits - delta_bits) & (delta_unit - 1);
+      int next = fixed >> frac_bits;
+      int d_l = delta_l * interp;
+      int d_r = delta_r * interp;
+
+#ifdef BLIP_ASSERT
+      /* Fails if buffer size was exceeded */
+      assert( next <= m->size + end_frame_extra );
+#endif
+
+      if (next != pos)
+      {
+        /* flush first pending tap */
+        out_l[pos] += acc_l[0];
+        out_r[pos] += acc_r[0];
+
+        if (next == pos + 1)
+        {
+          /* second pending tap becomes first one */
+          acc_l[0] = acc_l[1];
+          acc_r[0] = acc_r[1];
+        }
+        else
+        {
+          /* flush second pending tap */
+          out_l[pos + 1] += acc_l[1];
+          out_r[pos + 1] += acc_r[1];
+          acc_l[0] = 0;
+          acc_r[0] = 0;
+        }
+
+        acc_l[1] = 0;
+        acc_r[1] = 0;
+        pos = next;
+      }
+
+      acc_l[0] += delta_l * delta_unit - d_l;
+      acc_l[1] += d_l;
+      acc_r[0] += delta_r * delta_unit - d_r;
+      acc_r[1] += d_r;
+
+      prev_l = levels[0];
+      prev_r = levels[1];
+    }
+
+    levels += 2;
+    t += m->factor;
+  }
+
+  /* flush pending taps */
+  if (pos >= 0)
+  {
+    out_l[pos] += acc_l[0];
+    out_l[pos + 1] += acc_l[1];
+    out_r[pos] += acc_r[0];
+    out_r[pos + 1] += acc_r[1];
+  }
+
+  last[0] = prev_l;
+  last[1] = prev_r;
+}
+
 #else
 
 void blip_add_delta( blip_t* m, unsigned time, int delta )
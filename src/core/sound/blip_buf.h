@@ -37,6 +37,11 @@ void blip_add_delta( blip_t*, unsigned time, int delta_l, int delta_r );
 /** Same as blip_add_delta(), but uses faster, lower-quality synthesis. */
 void blip_add_delta_fast( blip_t*, unsigned time, int delta_l, int delta_r );
 
+/** Adds deltas between count consecutive stereo levels (interleaved left/right
+values, one per clock starting at specified clock time) using faster, lower-quality
+synthesis. last[] holds previous left/right levels on input and is updated. */
+void blip_add_levels_fast( blip_t*, unsigned time, int count, int const levels [], int last [2] );
+
 #else
 
 /** Adds positive/negative delta into buffer at specified clock time. */
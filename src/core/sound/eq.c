@@ -23,6 +23,9 @@
 // - Uses 4 first order filters in series, should give 24dB per octave
 //
 // - Now with P4 Denormal fix :)
+//
+// - Processes a whole interleaved stereo buffer at once, with low & high band
+//   filters of both channels as four single-precision lanes (easily vectorized)
 
 
 //----------------------------------------------------------------------------*/
@@ -41,7 +44,7 @@
 //| Constants |
 // -----------*/
 
-static double vsa = (1.0 / 4294967295.0); /* Very small amount (Denormal Fix) */
+static const float vsa = 1.0e-18f; /* Very small amount (Denormal Fix) */
 
 
 /* ---------------
@@ -63,70 +66,104 @@ void init_3band_state(EQSTATE * es, int lowfreq, int highfreq, int mixfreq)
 
     /* Set Low/Mid/High gains to unity */
 
-    es->lg = 1.0;
-    es->mg = 1.0;
-    es->hg = 1.0;
+    es->lg = 1.0f;
+    es->mg = 1.0f;
+    es->hg = 1.0f;
 
     /* Calculate filter cutoff frequencies */
 
-    es->lf = 2 * sin(M_PI * ((double) lowfreq / (double) mixfreq));
-    es->hf = 2 * sin(M_PI * ((double) highfreq / (double) mixfreq));
+    es->f[0] = es->f[1] = (float) (2 * sin(M_PI * ((double) lowfreq / (double) mixfreq)));
+    es->f[2] = es->f[3] = (float) (2 * sin(M_PI * ((double) highfreq / (double) mixfreq)));
 }
 
 
-/* ---------------
-//| EQ one sample |
-// ---------------*/
+/* ----------------------
+//| EQ stereo samples |
+// ----------------------*/
 
-/* - sample can be any range you like :)
+/* - buffer holds interleaved left & right 16-bit samples
 //
-// Note that the output will depend on the gain settings for each band 
-// (especially the bass) so may require clipping before output, but you 
-// knew that anyway :)*/
+// Note that the output will depend on the gain settings for each band
+// (especially the bass) so it is clipped to 16-bit samples :)*/
 
-double do_3band(EQSTATE * es, int sample)
+void do_3band(EQSTATE * es, short *buffer, int samples)
 {
-    /* Locals */
+    /* Locals (filter lanes are kept out of EQSTATE so they can stay in registers) */
+
+    float f[4], p0[4], p1[4], p2[4], p3[4], x[4];
+    float sdm1[2], sdm2[2], sdm3[2];
+    float lg = es->lg, mg = es->mg, hg = es->hg;
+    int i;
+
+    if (samples <= 0)
+    {
+        return;
+    }
+
+    memcpy(f, es->f, sizeof(f));
+    memcpy(p0, es->p0, sizeof(p0));
+    memcpy(p1, es->p1, sizeof(p1));
+    memcpy(p2, es->p2, sizeof(p2));
+    memcpy(p3, es->p3, sizeof(p3));
+    memcpy(sdm1, es->sdm1, sizeof(sdm1));
+    memcpy(sdm2, es->sdm2, sizeof(sdm2));
+    memcpy(sdm3, es->sdm3, sizeof(sdm3));
+
+    do
+    {
+        /* Same input for low & high band filters */
+
+        x[0] = x[2] = buffer[0];
+        x[1] = x[3] = buffer[1];
 
-    double l, m, h;   /* Low / Mid / High - Sample Values */
+        /* Filters #1 (lowpass) & #2 (highpass) */
 
-    /* Filter #1 (lowpass) */
+        for (i = 0; i < 4; i++)
+        {
+            p0[i] += (f[i] * (x[i] - p0[i])) + vsa;
+            p1[i] += (f[i] * (p0[i] - p1[i]));
+            p2[i] += (f[i] * (p1[i] - p2[i]));
+            p3[i] += (f[i] * (p2[i] - p3[i]));
+        }
 
-    es->f1p0 += (es->lf * ((double) sample - es->f1p0)) + vsa;
-    es->f1p1 += (es->lf * (es->f1p0 - es->f1p1));
-    es->f1p2 += (es->lf * (es->f1p1 - es->f1p2));
-    es->f1p3 += (es->lf * (es->f1p2 - es->f1p3));
+        for (i = 0; i < 2; i++)
+        {
+            float l, m, h;   /* Low / Mid / High - Sample Values */
 
-    l = es->f1p3;
+            l = p3[i];
+            h = sdm3[i] - p3[i + 2];
 
-    /* Filter #2 (highpass) */
+            /* Calculate midrange (signal - (low + high)) */
 
-    es->f2p0 += (es->hf * ((double) sample - es->f2p0)) + vsa;
-    es->f2p1 += (es->hf * (es->f2p0 - es->f2p1));
-    es->f2p2 += (es->hf * (es->f2p1 - es->f2p2));
-    es->f2p3 += (es->hf * (es->f2p2 - es->f2p3));
+            m = x[i] - (h + l);
 
-    h = es->sdm3 - es->f2p3;
+            /* Scale & Combine */
 
-    /* Calculate midrange (signal - (low + high)) */
+            l = (l * lg) + (m * mg) + (h * hg);
 
-    /* m = es->sdm3 - (h + l); */
-    /* fix from http://www.musicdsp.org/showArchiveComment.php?ArchiveID=236 ? */
-    m = sample - (h + l);
+            /* Shuffle history buffer */
 
-    /* Scale, Combine and store */
+            sdm3[i] = sdm2[i];
+            sdm2[i] = sdm1[i];
+            sdm1[i] = x[i];
 
-    l *= es->lg;
-    m *= es->mg;
-    h *= es->hg;
+            /* Clip & store result */
 
-    /* Shuffle history buffer */
+            if (l > 32767.0f) l = 32767.0f;
+            else if (l < -32768.0f) l = -32768.0f;
 
-    es->sdm3 = es->sdm2;
-    es->sdm2 = es->sdm1;
-    es->sdm1 = sample;
+            buffer[i] = (short) l;
+        }
 
-    /* Return result */
+        buffer += 2;
+    }
+    while (--samples);
 
-    return (int) (l + m + h);
+    memcpy(es->p0, p0, sizeof(p0));
+    memcpy(es->p1, p1, sizeof(p1));
+    memcpy(es->p2, p2, sizeof(p2));
+    memcpy(es->p3, p3, sizeof(p3));
+    memcpy(es->sdm1, sdm1, sizeof(sdm1));
+    memcpy(es->sdm2, sdm2, sizeof(sdm2));
+    memcpy(es->sdm3, sdm3, sizeof(sdm3));
 }
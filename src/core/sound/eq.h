@@ -23,34 +23,29 @@
 //| Structures |
 // ------------*/
 
-typedef struct {
-    /* Filter #1 (Low band) */
-
-    double lf;      /* Frequency */
-    double f1p0;      /* Poles ... */
-    double f1p1;
-    double f1p2;
-    double f1p3;
+/* Low & high band filters of both stereo channels are run together, as four */
+/* lanes of single-precision data: left low, right low, left high, right high */
 
-    /* Filter #2 (High band) */
+typedef struct {
+    /* Filters #1 (Low band) & #2 (High band) */
 
-    double hf;      /* Frequency */
-    double f2p0;      /* Poles ... */
-    double f2p1;
-    double f2p2;
-    double f2p3;
+    float f[4];       /* Frequencies */
+    float p0[4];      /* Poles ... */
+    float p1[4];
+    float p2[4];
+    float p3[4];
 
-    /* Sample history buffer */
+    /* Sample history buffer (left, right) */
 
-    double sdm1;      /* Sample data minus 1 */
-    double sdm2;      /*                   2 */
-    double sdm3;      /*                   3 */
+    float sdm1[2];    /* Sample data minus 1 */
+    float sdm2[2];    /*                   2 */
+    float sdm3[2];    /*                   3 */
 
     /* Gain Controls */
 
-    double lg;      /* low  gain */
-    double mg;      /* mid  gain */
-    double hg;      /* high gain */
+    float lg;         /* low  gain */
+    float mg;         /* mid  gain */
+    float hg;         /* high gain */
 
 } EQSTATE;
 
@@ -61,7 +56,7 @@ typedef struct {
 
 extern void init_3band_state(EQSTATE * es, int lowfreq, int highfreq,
            int mixfreq);
-extern double do_3band(EQSTATE * es, int sample);
+extern void do_3band(EQSTATE * es, short *buffer, int samples);
 
 
 #endif        /* #ifndef __EQ3BAND__ */
@@ -462,23 +462,25 @@ void psg_end_frame(unsigned int clocks)
 
 static void psg_update(unsigned int clocks)
 {
-  int i, timestamp, polarity;
+  int i, timestamp, polarity, nyquistInc;
+  void (*add_delta)(blip_t*, unsigned int, int, int);
   if (audio_hard_disable) return;
 
+  PROFILER_ENTER(PROF_PSG);
+
+  /* select resampling quality once for all channels */
+  add_delta = config.hq_psg ? blip_add_delta : blip_add_delta_fast;
+
+  /* tone generators toggling at least once per output sample are above Nyquist frequency */
+  nyquistInc = snd.sample_rate ? (system_clock / snd.sample_rate) : 0;
+
   for (i=0; i<4; i++)
   {
     /* apply any pending channel volume variations */
     if (psg.chanDelta[i][0] | psg.chanDelta[i][1])
     {
       /* update channel output */
-      if (config.hq_psg)
-      {
-        blip_add_delta(snd.blips[0], psg.clocks, psg.chanDelta[i][0], psg.chanDelta[i][1]);
-      }
-      else
-      {
-        blip_add_delta_fast(snd.blips[0], psg.clocks, psg.chanDelta[i][0], psg.chanDelta[i][1]);
-      }
+      add_delta(snd.blips[0], psg.clocks, psg.chanDelta[i][0], psg.chanDelta[i][1]);
 
       /* clear pending channel volume variations */
       psg.chanDelta[i][0] = 0;
@@ -494,24 +496,55 @@ static void psg_update(unsigned int clocks)
     /* Tone channels */
     if (i < 3)
     {
-      /* process all transitions occurring until current clock timestamp */
-      while (timestamp < clocks)
+      if (timestamp < clocks)
       {
-        /* invert tone generator polarity */
-        polarity = -polarity;
+        int freqInc = psg.freqInc[i];
+        int out[2];
+
+        out[0] = psg.chanOut[i][0];
+        out[1] = psg.chanOut[i][1];
 
-        /* update channel output */
-        if (config.hq_psg)
+        /* muted channel: only advance tone generator */
+        if (!(out[0] | out[1]))
         {
-          blip_add_delta(snd.blips[0], timestamp, polarity*psg.chanOut[i][0], polarity*psg.chanOut[i][1]);
+          int count = (clocks - timestamp + freqInc - 1) / freqInc;
+          if (count & 1) polarity = -polarity;
+          timestamp += count * freqInc;
         }
-        else
+
+        /* tone frequency above Nyquist frequency: only its average level is audible */
+        else if ((freqInc < nyquistInc) && ((clocks - timestamp) > (2 * freqInc)))
         {
-          blip_add_delta_fast(snd.blips[0], timestamp, polarity*psg.chanOut[i][0], polarity*psg.chanOut[i][1]);
+          int count = (clocks - timestamp + freqInc - 1) / freqInc;
+          int level = (polarity > 0) ? 1 : 0;
+
+          /* switch to average level on first transition */
+          add_delta(snd.blips[0], timestamp, (out[0] >> 1) - level*out[0], (out[1] >> 1) - level*out[1]);
+
+          /* restore generator level on last transition */
+          if (count & 1) polarity = -polarity;
+          level = (polarity > 0) ? 1 : 0;
+          timestamp += (count - 1) * freqInc;
+          add_delta(snd.blips[0], timestamp, level*out[0] - (out[0] >> 1), level*out[1] - (out[1] >> 1));
+          timestamp += freqInc;
         }
 
-        /* timestamp of next transition */
-        timestamp += psg.freqInc[i];
+        else
+        {
+          /* process all transitions occurring until current clock timestamp */
+          do
+          {
+            /* invert tone generator polarity */
+            polarity = -polarity;
+
+            /* update channel output */
+            add_delta(snd.blips[0], timestamp, polarity*out[0], polarity*out[1]);
+
+            /* timestamp of next transition */
+            timestamp += freqInc;
+          }
+          while (timestamp < clocks);
+        }
       }
     }
 
@@ -550,14 +583,10 @@ static void psg_update(unsigned int clocks)
           /* shift register output variation */
           shiftOutput = (shiftValue & 0x1) - shiftOutput;
 
-          /* update noise channel output */
-          if (config.hq_psg)
-          {
-            blip_add_delta(snd.blips[0], timestamp, shiftOutput*psg.chanOut[3][0], shiftOutput*psg.chanOut[3][1]);
-          }
-          else
+          /* update noise channel output (if modified) */
+          if (shiftOutput && (psg.chanOut[3][0] | psg.chanOut[3][1]))
           {
-            blip_add_delta_fast(snd.blips[0], timestamp, shiftOutput*psg.chanOut[3][0], shiftOutput*psg.chanOut[3][1]);
+            add_delta(snd.blips[0], timestamp, shiftOutput*psg.chanOut[3][0], shiftOutput*psg.chanOut[3][1]);
           }
         }
 
@@ -575,4 +604,6 @@ static void psg_update(unsigned int clocks)
     /* save channel generator polarity */
     psg.polarity[i] = polarity;
   }
+
+  PROFILER_LEAVE();
 }  
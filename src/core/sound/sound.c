@@ -40,6 +40,12 @@
 #include "shared.h"
 #include "blip_buf.h"
 
+#ifdef USE_FM_THREAD
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
 int8 audio_hard_disable = 0;
 
 /* YM2612 internal clock = input clock / 6 = (master clock / 7) / 6 */
@@ -82,6 +88,19 @@ static int opll_cycles;
 static int opll_status;
 #endif
 
+/* Run FM chip samples */
+INLINE void fm_run(int samples)
+{
+  /* run FM chip to sample buffer */
+  YM_Update(fm_ptr, samples);
+
+  /* update FM buffer pointer */
+  fm_ptr += (samples * 2);
+
+  /* update FM cycle counter */
+  fm_cycles_count += (samples * fm_cycles_ratio);
+}
+
 /* Run FM chip until required M-cycles */
 INLINE void fm_update(int cycles)
 {
@@ -90,25 +109,238 @@ INLINE void fm_update(int cycles)
     /* number of samples to run */
     int samples = (cycles - fm_cycles_count + fm_cycles_ratio - 1) / fm_cycles_ratio;
 
-    /* run FM chip to sample buffer */
-    YM_Update(fm_ptr, samples);
+    PROFILER_ENTER(PROF_FM);
+    fm_run(samples);
+    PROFILER_LEAVE();
+  }
+}
+
+#ifdef USE_FM_THREAD
+
+/* YM2612 (MAME core) register writes are logged with their timestamp by the emulation thread and */
+/* replayed by a worker thread, which runs the FM chip until each write timestamp before applying */
+/* it, exactly like YM2612_Write() does. FM status is read from a copy of the chip timers updated */
+/* on the same sample grid by the emulation thread. FM chip state and sample buffer are only accessed */
+/* from the emulation thread once all logged writes have been replayed (see fm_sync), so output */
+/* stays identical to synchronous emulation */
+
+/* Logged writes (power of two) */
+#define FM_QUEUE_SIZE 0x1000
+
+/* Waiting threads yield the CPU after this number of polling loops */
+#define FM_SPIN_COUNT 1000
+
+/* Worker thread goes to sleep after this number of polling loops without any logged write */
+#define FM_IDLE_COUNT 100000
+
+#if defined(__i386__) || defined(__x86_64__)
+#define FM_PAUSE() __builtin_ia32_pause()
+#else
+#define FM_PAUSE()
+#endif
+
+#define FM_LOAD(x)    __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define FM_STORE(x,v) __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+
+typedef struct
+{
+  unsigned int cycles;
+  uint16 address;
+  uint8 data;
+} fm_write_t;
+
+static struct
+{
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int started;
+  int disabled;
+  int sleeping;
+  int quit;
+  unsigned int head;              /* number of logged writes (written by emulation thread) */
+  unsigned int tail;              /* number of replayed writes (written by worker thread) */
+  fm_write_t log[FM_QUEUE_SIZE];
+} fm_thread;
+
+/* FM timers cycle counter (emulation thread) */
+static int fm_timers_count;
+
+static void *fm_thread_main(void *arg)
+{
+  unsigned int tail = fm_thread.tail;
+
+  while (1)
+  {
+    fm_write_t *w;
+    int spin = 0;
+
+    /* wait for logged writes */
+    while (FM_LOAD(fm_thread.head) == tail)
+    {
+      if (FM_LOAD(fm_thread.quit))
+      {
+        return NULL;
+      }
+
+      if (++spin < FM_SPIN_COUNT)
+      {
+        FM_PAUSE();
+        continue;
+      }
+
+      if (spin < FM_IDLE_COUNT)
+      {
+        sched_yield();
+        continue;
+      }
+
+      /* no more writes for a while (end of frame, emulation paused, ...) */
+      pthread_mutex_lock(&fm_thread.mutex);
+      FM_STORE(fm_thread.sleeping, 1);
+      while ((FM_LOAD(fm_thread.head) == tail) && !FM_LOAD(fm_thread.quit))
+      {
+        pthread_cond_wait(&fm_thread.cond, &fm_thread.mutex);
+      }
+      FM_STORE(fm_thread.sleeping, 0);
+      pthread_mutex_unlock(&fm_thread.mutex);
+      spin = 0;
+    }
+
+    w = &fm_thread.log[tail & (FM_QUEUE_SIZE - 1)];
 
-    /* update FM buffer pointer */
-    fm_ptr += (samples * 2);
+    /* detect DATA port write */
+    if (w->address & 1)
+    {
+      /* synchronize FM chip with CPU */
+      if ((int)w->cycles > fm_cycles_count)
+      {
+        fm_run((w->cycles - fm_cycles_count + fm_cycles_ratio - 1) / fm_cycles_ratio);
+      }
+    }
+
+    /* write FM register */
+    YM2612Write(w->address, w->data);
+
+    FM_STORE(fm_thread.tail, ++tail);
+  }
+}
+
+static int fm_thread_start(void)
+{
+  /* both threads would compete for the same CPU */
+  if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+  {
+    fm_thread.disabled = 1;
+    return 0;
+  }
+
+  pthread_mutex_init(&fm_thread.mutex, NULL);
+  pthread_cond_init(&fm_thread.cond, NULL);
+  fm_thread.head = fm_thread.tail = 0;
+  fm_thread.sleeping = fm_thread.quit = 0;
+  if (pthread_create(&fm_thread.thread, NULL, fm_thread_main, NULL))
+  {
+    /* fallback to synchronous FM emulation */
+    pthread_cond_destroy(&fm_thread.cond);
+    pthread_mutex_destroy(&fm_thread.mutex);
+    fm_thread.disabled = 1;
+    return 0;
+  }
+
+  /* FM timers are now updated by emulation thread */
+  YM2612TimersSync();
+  fm_timers_count = fm_cycles_count;
+
+  fm_thread.started = 1;
+  return 1;
+}
+
+static void fm_sync(void)
+{
+  /* wait until all logged writes have been replayed */
+  if (FM_LOAD(fm_thread.tail) != fm_thread.head)
+  {
+    int spin = 0;
+
+    PROFILER_ENTER(PROF_FM);
+    while (FM_LOAD(fm_thread.tail) != fm_thread.head)
+    {
+      if (++spin < FM_SPIN_COUNT)
+      {
+        FM_PAUSE();
+      }
+      else
+      {
+        sched_yield();
+      }
+    }
+    PROFILER_LEAVE();
+  }
+}
+
+static void fm_timers_sync(void)
+{
+  /* resynchronize FM timers with (idle) FM chip */
+  if (fm_thread.started)
+  {
+    YM2612TimersSync();
+    fm_timers_count = fm_cycles_count;
+  }
+}
 
-    /* update FM cycle counter */
-    fm_cycles_count += (samples * fm_cycles_ratio);
+/* Run FM timers until required M-cycles */
+INLINE void fm_timers_update(int cycles)
+{
+  if (cycles > fm_timers_count)
+  {
+    /* number of samples to run (same as fm_update) */
+    int samples = (cycles - fm_timers_count + fm_cycles_ratio - 1) / fm_cycles_ratio;
+    YM2612TimersUpdate(samples);
+    fm_timers_count += (samples * fm_cycles_ratio);
   }
 }
 
+void sound_shutdown(void)
+{
+  if (fm_thread.started)
+  {
+    fm_sync();
+
+    pthread_mutex_lock(&fm_thread.mutex);
+    FM_STORE(fm_thread.quit, 1);
+    pthread_cond_signal(&fm_thread.cond);
+    pthread_mutex_unlock(&fm_thread.mutex);
+
+    pthread_join(fm_thread.thread, NULL);
+    pthread_cond_destroy(&fm_thread.cond);
+    pthread_mutex_destroy(&fm_thread.mutex);
+    fm_thread.started = 0;
+  }
+
+  fm_thread.disabled = 0;
+}
+
+#define FM_SYNC() fm_sync()
+#define FM_TIMERS_SYNC() fm_timers_sync()
+#else
+#define FM_SYNC()
+#define FM_TIMERS_SYNC()
+#endif /* USE_FM_THREAD */
+
 static void YM2612_Reset(unsigned int cycles)
 {
+  /* wait for FM worker thread */
+  FM_SYNC();
+
   /* synchronize FM chip with CPU */
   fm_update(cycles);
 
   /* reset FM chip */
   YM2612ResetChip();
   fm_cycles_busy = 0;
+
+  FM_TIMERS_SYNC();
 }
 
 static void YM2612_Write(unsigned int cycles, unsigned int a, unsigned int v)
@@ -155,6 +387,85 @@ static unsigned int YM2612_Read(unsigned int cycles, unsigned int a)
   return 0x00;
 }
 
+#ifdef USE_FM_THREAD
+static void YM2612_WriteAsync(unsigned int cycles, unsigned int a, unsigned int v)
+{
+  unsigned int head = fm_thread.head;
+
+  if (!fm_thread.started && (fm_thread.disabled || !fm_thread_start()))
+  {
+    YM2612_Write(cycles, a, v);
+    return;
+  }
+
+  /* detect DATA port write */
+  if (a & 1)
+  {
+    /* synchronize FM timers with CPU */
+    fm_timers_update(cycles);
+
+    /* set FM BUSY end cycle (discrete or ASIC-integrated YM2612 chip only) */
+    if (config.ym2612 < YM2612_ENHANCED)
+    {
+      fm_cycles_busy = (((cycles + YM2612_CLOCK_RATIO - 1) / YM2612_CLOCK_RATIO) + 32) * YM2612_CLOCK_RATIO;
+    }
+  }
+
+  /* write FM timers register */
+  YM2612TimersWrite(a, v);
+
+  /* wait for a free slot */
+  if ((head - FM_LOAD(fm_thread.tail)) >= FM_QUEUE_SIZE)
+  {
+    fm_sync();
+  }
+
+  /* log FM register write */
+  fm_thread.log[head & (FM_QUEUE_SIZE - 1)].cycles = cycles;
+  fm_thread.log[head & (FM_QUEUE_SIZE - 1)].address = a;
+  fm_thread.log[head & (FM_QUEUE_SIZE - 1)].data = v;
+  FM_STORE(fm_thread.head, head + 1);
+
+  /* wake up worker thread if needed */
+  if (FM_LOAD(fm_thread.sleeping))
+  {
+    pthread_mutex_lock(&fm_thread.mutex);
+    pthread_cond_signal(&fm_thread.cond);
+    pthread_mutex_unlock(&fm_thread.mutex);
+  }
+}
+
+static unsigned int YM2612_ReadAsync(unsigned int cycles, unsigned int a)
+{
+  if (!fm_thread.started)
+  {
+    return YM2612_Read(cycles, a);
+  }
+
+  /* FM status can only be read from (A0,A1)=(0,0) on discrete YM2612 */
+  if ((a == 0) || (config.ym2612 > YM2612_DISCRETE))
+  {
+    /* synchronize FM timers with CPU */
+    fm_timers_update(cycles);
+
+    /* read FM status */
+    if (cycles >= fm_cycles_busy)
+    {
+      /* BUSY flag cleared */
+      return YM2612TimersRead();
+    }
+    else
+    {
+      /* BUSY flag set */
+      return YM2612TimersRead() | 0x80;
+    }
+  }
+
+  /* invalid FM status address */
+  return 0x00;
+}
+#endif
+
 static void YM2413_Reset(unsigned int cycles)
 {
   /* synchronize FM chip with CPU */
@@ -185,11 +496,25 @@ static unsigned int YM2413_Read(unsigned int cycles, unsigned int a)
 #ifdef HAVE_YM3438_CORE
 static void YM3438_Update(int *buffer, int length)
 {
-  int i, j;
-  for (i = 0; i < length; i++)
+  int i, j, n;
+  while (length > 0)
   {
-    OPN2_Clock(&ym3438, ym3438_accm[ym3438_cycles]);
-    ym3438_cycles = (ym3438_cycles + 1) % 24;
+    /* run FM chip until end of output accumulator (24 internal cycles) */
+    n = 24 - ym3438_cycles;
+    if (n > length)
+    {
+      n = length;
+    }
+    OPN2_Clocks(&ym3438, &ym3438_accm[ym3438_cycles], n);
+    ym3438_cycles = (ym3438_cycles + n) % 24;
+    length -= n;
+
+    /* output is only updated once accumulator is complete */
+    for (i = 1; i < n; i++)
+    {
+      *buffer++ = ym3438_sample[0] * 11;
+      *buffer++ = ym3438_sample[1] * 11;
+    }
     if (ym3438_cycles == 0)
     {
       ym3438_sample[0] = 0;
@@ -322,8 +647,13 @@ void sound_init( void )
       YM2612Config(config.ym2612);
       YM_Update = YM2612Update;
       fm_reset = YM2612_Reset;
+#ifdef USE_FM_THREAD
+      fm_write = YM2612_WriteAsync;
+      fm_read = YM2612_ReadAsync;
+#else
       fm_write = YM2612_Write;
       fm_read = YM2612_Read;
+#endif
 
       /* chip is running at sample clock */
       fm_cycles_ratio = YM2612_CLOCK_RATIO * 24;
@@ -393,11 +723,15 @@ void sound_reset(void)
   
   /* reset FM cycle counters */
   fm_cycles_start = fm_cycles_count = 0;
+  FM_TIMERS_SYNC();
 }
 
 #ifdef __LIBRETRO__
 void sound_update_fm_function_pointers(void)
 {
+  /* wait for FM worker thread */
+  FM_SYNC();
+
   /* Only set function pointers for YM_Update, fm_reset, fm_write, fm_read */
   if (audio_hard_disable)
   {
@@ -427,8 +761,13 @@ void sound_update_fm_function_pointers(void)
       /* MAME OPN2 */
       YM_Update = YM2612Update;
       fm_reset = YM2612_Reset;
+#ifdef USE_FM_THREAD
+      fm_write = YM2612_WriteAsync;
+      fm_read = YM2612_ReadAsync;
+#else
       fm_write = YM2612_Write;
       fm_read = YM2612_Read;
+#endif
     }
   }
   else
@@ -452,6 +791,9 @@ int sound_update(unsigned int cycles)
   {
     int prev_l, prev_r, preamp, time, l, r, *ptr;
 
+    /* wait for FM worker thread */
+    FM_SYNC();
+
     /* Run FM chip until end of frame */
     fm_update(cycles);
 
@@ -470,6 +812,8 @@ int sound_update(unsigned int cycles)
 
     if (!audio_hard_disable)
     {
+      PROFILER_ENTER(PROF_BLIP);
+
       /* flush FM samples */
       if (config.hq_fm)
       {
@@ -503,6 +847,8 @@ int sound_update(unsigned int cycles)
           time += fm_cycles_ratio;
         } while (time < cycles);
       }
+
+      PROFILER_LEAVE();
     }
     else
     {
@@ -526,6 +872,8 @@ int sound_update(unsigned int cycles)
     {
       fm_cycles_busy = 0;
     }
+
+    FM_TIMERS_SYNC();
   }
 
   /* end of blip buffer time frame */
@@ -538,6 +886,9 @@ int sound_update(unsigned int cycles)
 int sound_context_save(uint8 *state)
 {
   int bufferptr = 0;
+
+  /* wait for FM worker thread */
+  FM_SYNC();
   
   if ((system_hw & SYSTEM_PBC) == SYSTEM_MD)
   {
@@ -588,6 +939,9 @@ int sound_context_load(uint8 *state)
 {
   int bufferptr = 0;
 
+  /* wait for FM worker thread */
+  FM_SYNC();
+
   if ((system_hw & SYSTEM_PBC) == SYSTEM_MD)
   {
 #ifdef HAVE_YM3438_CORE
@@ -632,6 +986,7 @@ int sound_context_load(uint8 *state)
 
   load_param(&fm_cycles_start,sizeof(fm_cycles_start));
   fm_cycles_count = fm_cycles_start;
+  FM_TIMERS_SYNC();
 
   return bufferptr;
 }
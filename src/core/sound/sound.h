@@ -52,4 +52,8 @@ extern unsigned int (*fm_read)(unsigned int cycles, unsigned int address);
 extern void save_sound_buffer();
 extern void restore_sound_buffer();
 
+#ifdef USE_FM_THREAD
+extern void sound_shutdown(void);
+#endif
+
 #endif /* _SOUND_H_ */
@@ -1433,9 +1433,24 @@ INLINE signed int op_calc1(UINT32 phase, unsigned int env, unsigned int pm, unsi
   return (tl_tab[p] & opmask);
 }
 
-INLINE void chan_calc(FM_CH *CH, int num)
+/* silent channels fast paths can be disabled by defining YM2612_NO_FAST_PATH (reference implementation) */
+INLINE void chan_calc(FM_CH *CH)
 {
-  do
+#ifndef YM2612_NO_FAST_PATH
+  /* all operators are silent (Key OFF or attenuation above output range) */
+  if ((CH->SLOT[SLOT1].vol_out >= ENV_QUIET) && (CH->SLOT[SLOT2].vol_out >= ENV_QUIET) &&
+      (CH->SLOT[SLOT3].vol_out >= ENV_QUIET) && (CH->SLOT[SLOT4].vol_out >= ENV_QUIET))
+  {
+    /* feedback & MEM are updated as if operators output was zero */
+    CH->op1_out[0] = CH->op1_out[1];
+    CH->op1_out[1] = 0;
+
+    /* MEM value is kept when not used */
+    if (CH->mem_connect != &mem)
+      CH->mem_value = 0;
+  }
+  else
+#endif
   {
     INT32 out = 0;
     UINT32 AM = ym2612.OPN.LFO_AM >> CH->ams;
@@ -1479,37 +1494,52 @@ INLINE void chan_calc(FM_CH *CH, int num)
 
     /* store current MEM */
     CH->mem_value = mem;
+  }
 
-    /* update phase counters AFTER output calculations */
-    if (CH->pms)
+  /* update phase counters AFTER output calculations */
+  if (CH->pms)
+  {
+    /* 3-slot mode */
+    if ((ym2612.OPN.ST.mode & 0xC0) && (CH == &ym2612.CH[2]))
     {
-      /* 3-slot mode */
-      if ((ym2612.OPN.ST.mode & 0xC0) && (CH == &ym2612.CH[2]))
-      {
-        /* keyscale code is not modifiedby LFO */
-        UINT8 kc = ym2612.CH[2].kcode;
-        UINT32 pm = ym2612.CH[2].pms + ym2612.OPN.LFO_PM;
-        update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT1], pm, kc, ym2612.OPN.SL3.block_fnum[1]);
-        update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT2], pm, kc, ym2612.OPN.SL3.block_fnum[2]);
-        update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT3], pm, kc, ym2612.OPN.SL3.block_fnum[0]);
-        update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT4], pm, kc, ym2612.CH[2].block_fnum);
-      }
-      else
-      {
-        update_phase_lfo_channel(CH);
-      }
+      /* keyscale code is not modifiedby LFO */
+      UINT8 kc = ym2612.CH[2].kcode;
+      UINT32 pm = ym2612.CH[2].pms + ym2612.OPN.LFO_PM;
+      update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT1], pm, kc, ym2612.OPN.SL3.block_fnum[1]);
+      update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT2], pm, kc, ym2612.OPN.SL3.block_fnum[2]);
+      update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT3], pm, kc, ym2612.OPN.SL3.block_fnum[0]);
+      update_phase_lfo_slot(&ym2612.CH[2].SLOT[SLOT4], pm, kc, ym2612.CH[2].block_fnum);
     }
-    else  /* no LFO phase modulation */
+    else
     {
-      CH->SLOT[SLOT1].phase += CH->SLOT[SLOT1].Incr;
-      CH->SLOT[SLOT2].phase += CH->SLOT[SLOT2].Incr;
-      CH->SLOT[SLOT3].phase += CH->SLOT[SLOT3].Incr;
-      CH->SLOT[SLOT4].phase += CH->SLOT[SLOT4].Incr;
+      update_phase_lfo_channel(CH);
     }
+  }
+  else  /* no LFO phase modulation */
+  {
+    CH->SLOT[SLOT1].phase += CH->SLOT[SLOT1].Incr;
+    CH->SLOT[SLOT2].phase += CH->SLOT[SLOT2].Incr;
+    CH->SLOT[SLOT3].phase += CH->SLOT[SLOT3].Incr;
+    CH->SLOT[SLOT4].phase += CH->SLOT[SLOT4].Incr;
+  }
+}
 
-    /* next channel */
-    CH++;
-  } while (--num);
+/* skip channel calculations over a number of samples (all operators off, no LFO phase modulation) */
+INLINE void chan_skip(FM_CH *CH, int length)
+{
+  /* feedback & MEM are updated as if operators output was zero */
+  CH->op1_out[0] = (length > 1) ? 0 : CH->op1_out[1];
+  CH->op1_out[1] = 0;
+
+  /* MEM value is kept when not used */
+  if (CH->mem_connect != &mem)
+    CH->mem_value = 0;
+
+  /* update phase counters */
+  CH->SLOT[SLOT1].phase += (UINT32)CH->SLOT[SLOT1].Incr * length;
+  CH->SLOT[SLOT2].phase += (UINT32)CH->SLOT[SLOT2].Incr * length;
+  CH->SLOT[SLOT3].phase += (UINT32)CH->SLOT[SLOT3].Incr * length;
+  CH->SLOT[SLOT4].phase += (UINT32)CH->SLOT[SLOT4].Incr * length;
 }
 
 /* write a OPN mode register 0x20-0x2f */
@@ -2002,11 +2032,107 @@ unsigned int YM2612Read(void)
   return ym2612.OPN.ST.status;
 }
 
+#ifdef USE_FM_THREAD
+/* Timers state copy, used to read FM status from the emulation thread while the chip itself */
+/* is being updated by the FM worker thread (see sound.c). Timers are updated exactly as in */
+/* YM2612Update() and timer B counter only depends on the total number of updated samples, */
+/* so status flags are identical to those read from the chip when running synchronously. */
+static FM_ST timers;
+
+void YM2612TimersSync(void)
+{
+  timers = ym2612.OPN.ST;
+}
+
+void YM2612TimersUpdate(int length)
+{
+  int i;
+
+  /* timer A control */
+  if (timers.mode & 0x01)
+  {
+    for (i=0; i<length; i++)
+    {
+      if (--timers.TAC <= 0)
+      {
+        if (timers.mode & 0x04)
+          timers.status |= 0x01;
+        timers.TAC = timers.TAL;
+      }
+    }
+  }
+
+  /* timer B control */
+  if (timers.mode & 0x02)
+  {
+    timers.TBC -= length;
+    if (timers.TBC <= 0)
+    {
+      if (timers.mode & 0x08)
+        timers.status |= 0x02;
+      do
+      {
+        timers.TBC += timers.TBL;
+      }
+      while (timers.TBC <= 0);
+    }
+  }
+}
+
+void YM2612TimersWrite(unsigned int a, unsigned int v)
+{
+  v &= 0xff;
+
+  switch (a)
+  {
+    case 0:  /* address port 0 */
+      timers.address = v;
+      break;
+
+    case 2:  /* address port 1 */
+      timers.address = v | 0x100;
+      break;
+
+    default:  /* data port */
+      switch (timers.address)
+      {
+        case 0x24:  /* timer A High */
+          timers.TA = (timers.TA & 0x03)|(((int)v)<<2);
+          timers.TAL = 1024 - timers.TA;
+          break;
+        case 0x25:  /* timer A Low */
+          timers.TA = (timers.TA & 0x3fc)|(v&3);
+          timers.TAL = 1024 - timers.TA;
+          break;
+        case 0x26:  /* timer B */
+          timers.TB = v;
+          timers.TBL = (256 - v) << 4;
+          break;
+        case 0x27:  /* mode, timer control (see set_timers) */
+          if ((v&1) && !(timers.mode&1))
+            timers.TAC = timers.TAL;
+          if ((v&2) && !(timers.mode&2))
+            timers.TBC = timers.TBL;
+          timers.status &= (~v >> 4);
+          timers.mode = v;
+          break;
+      }
+      break;
+  }
+}
+
+unsigned int YM2612TimersRead(void)
+{
+  return timers.status;
+}
+#endif
+
 /* Generate samples for ym2612 */
 void YM2612Update(int *buffer, int length)
 {
-  int i;
+  int i, ch;
   int lt,rt;
+  unsigned int mask, active, idle;
 
   /* refresh PG increments and EG rates if required */
   refresh_fc_eg_chan(&ym2612.CH[0]);
@@ -2032,6 +2158,27 @@ void YM2612Update(int *buffer, int length)
   refresh_fc_eg_chan(&ym2612.CH[4]);
   refresh_fc_eg_chan(&ym2612.CH[5]);
 
+  /* calculated channels (channel 6 is replaced by DAC output in DAC mode) */
+  active = ym2612.dacen ? 0x1f : 0x3f;
+
+  /* channels with all operators off remain silent until next Key ON, which only occurs */
+  /* during this update in CSM mode (channel 3), so they don't need to be calculated */
+  idle = 0;
+#ifndef YM2612_NO_FAST_PATH
+  for (ch=0; ch<6; ch++)
+  {
+    FM_CH *CH = &ym2612.CH[ch];
+    if ((CH->SLOT[SLOT1].state == EG_OFF) && (CH->SLOT[SLOT2].state == EG_OFF) &&
+        (CH->SLOT[SLOT3].state == EG_OFF) && (CH->SLOT[SLOT4].state == EG_OFF) &&
+        !CH->pms && !((ch == 2) && (ym2612.OPN.ST.mode & 0x80)))
+    {
+      idle |= (1 << ch);
+    }
+  }
+#endif
+  idle &= active;
+  active &= ~idle;
+
   /* buffering */
   for(i=0; i<length; i++)
   {
@@ -2046,16 +2193,19 @@ void YM2612Update(int *buffer, int length)
     /* update SSG-EG output */
     update_ssg_eg_channels(&ym2612.CH[0]);
 
-    /* calculate FM */
-    if (!ym2612.dacen)
+    /* DAC Mode */
+    if (ym2612.dacen)
     {
-      chan_calc(&ym2612.CH[0],6);
+      out_fm[5] = ym2612.dacout;
     }
-    else
+
+    /* calculate FM */
+    for (ch=0, mask=active; mask; ch++, mask>>=1)
     {
-      /* DAC Mode */
-      out_fm[5] = ym2612.dacout;
-      chan_calc(&ym2612.CH[0],5);
+      if (mask & 1)
+      {
+        chan_calc(&ym2612.CH[ch]);
+      }
     }
 
     /* advance LFO */
@@ -2163,6 +2313,18 @@ void YM2612Update(int *buffer, int length)
     }
   }
 
+  /* update skipped channels */
+  if (length > 0)
+  {
+    for (ch=0; idle; ch++, idle>>=1)
+    {
+      if (idle & 1)
+      {
+        chan_skip(&ym2612.CH[ch], length);
+      }
+    }
+  }
+
   /* timer B control */
   INTERNAL_TIMER_B(length);
 }
@@ -31,4 +31,11 @@ extern unsigned int YM2612Read(void);
 extern int YM2612LoadContext(unsigned char *state);
 extern int YM2612SaveContext(unsigned char *state);
 
+#ifdef USE_FM_THREAD
+extern void YM2612TimersSync(void);
+extern void YM2612TimersUpdate(int length);
+extern void YM2612TimersWrite(unsigned int a, unsigned int v);
+extern unsigned int YM2612TimersRead(void);
+#endif
+
 #endif /* _YM2612_ */
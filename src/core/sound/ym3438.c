@@ -1045,11 +1045,18 @@ static void OPN2_ChOutput(ym3438_t *chip)
 static void OPN2_FMGenerate(ym3438_t *chip)
 {
     Bit32u slot = (chip->cycles + 19) % 24;
-    /* Calculate phase */
-    Bit16u phase = (chip->fm_mod[slot] + (chip->pg_phase[slot] >> 10)) & 0x3ff;
+    Bit16u phase;
     Bit16u quarter;
     Bit16u level;
     Bit16s output;
+    /* Silent operator: attenuated output is shifted out whatever the phase (level >> 8 >= 13) */
+    if (chip->eg_out[slot] >= 0x340 && !chip->mode_test_21[4])
+    {
+        chip->fm_out[slot] = 0;
+        return;
+    }
+    /* Calculate phase */
+    phase = (chip->fm_mod[slot] + (chip->pg_phase[slot] >> 10)) & 0x3ff;
     if (phase & 0x100)
     {
         quarter = (phase ^ 0xff) & 0xff;
@@ -1223,7 +1230,7 @@ void OPN2_SetChipType(Bit32u type)
     chip_type = type;
 }
 
-void OPN2_Clock(ym3438_t *chip, Bit16s *buffer)
+static void OPN2_DoClock(ym3438_t *chip, Bit16s *buffer, Bit32u quiet)
 {
     Bit32u slot = chip->cycles;
     chip->lfo_inc = chip->mode_test_21[1];
@@ -1299,10 +1306,15 @@ void OPN2_Clock(ym3438_t *chip, Bit16s *buffer)
     OPN2_KeyOn(chip);
 
     OPN2_ChOutput(chip);
-    OPN2_ChGenerate(chip);
 
-    OPN2_FMPrepare(chip);
-    OPN2_FMGenerate(chip);
+    /* Operator & channel outputs stay zero while chip is quiet */
+    if (!quiet)
+    {
+        OPN2_ChGenerate(chip);
+
+        OPN2_FMPrepare(chip);
+        OPN2_FMGenerate(chip);
+    }
 
     OPN2_PhaseGenerate(chip);
     OPN2_PhaseCalcIncrement(chip);
@@ -1360,6 +1372,67 @@ void OPN2_Clock(ym3438_t *chip, Bit16s *buffer)
         chip->status_time--;
 }
 
+/* Check that all operators are silent and can not be keyed on without a register write */
+static Bit32u OPN2_IsQuiet(ym3438_t *chip)
+{
+    Bit32u i;
+    if (chip->write_a || chip->write_d || chip->mode_csm || chip->mode_kon_csm)
+    {
+        return 0;
+    }
+    for (i = 0; i < 8; i++)
+    {
+        if (chip->mode_test_21[i] || chip->mode_test_2c[i])
+        {
+            return 0;
+        }
+    }
+    if (chip->mode_kon_channel != 0xff)
+    {
+        for (i = 0; i < 4; i++)
+        {
+            if (chip->mode_kon_operator[i])
+            {
+                return 0;
+            }
+        }
+    }
+    for (i = 0; i < 24; i++)
+    {
+        if (chip->mode_kon[i] || chip->eg_kon[i] || chip->eg_kon_latch[i] || chip->eg_kon_csm[i]
+         || chip->eg_level[i] != 0x3ff || chip->eg_out[i] != 0x3ff
+         || chip->fm_out[i] || chip->fm_mod[i])
+        {
+            return 0;
+        }
+    }
+    for (i = 0; i < 6; i++)
+    {
+        if (chip->fm_op1[i][0] || chip->fm_op1[i][1] || chip->fm_op2[i]
+         || chip->ch_acc[i] || chip->ch_out[i])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void OPN2_Clock(ym3438_t *chip, Bit16s *buffer)
+{
+    OPN2_DoClock(chip, buffer, 0);
+}
+
+void OPN2_Clocks(ym3438_t *chip, Bit16s (*buffer)[2], Bit32u count)
+{
+    Bit32u i;
+    /* Envelopes stay at maximal attenuation until next register write, FM stages can be skipped */
+    Bit32u quiet = count > 1 && OPN2_IsQuiet(chip);
+    for (i = 0; i < count; i++)
+    {
+        OPN2_DoClock(chip, buffer[i], quiet);
+    }
+}
+
 void OPN2_Write(ym3438_t *chip, Bit32u port, Bit8u data)
 {
     port &= 3;
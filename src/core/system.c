@@ -54,7 +54,7 @@ uint32 system_clock;
 int16 SVP_cycles = 800; 
 
 static uint8 pause_b;
-static EQSTATE eq[2];
+static EQSTATE eq;
 static int16 llp,rrp;
 
 /******************************************************************************************/
@@ -101,7 +101,7 @@ int audio_init(int samplerate, double framerate)
   return (0);
 }
 
-void audio_set_rate(int samplerate, double framerate)
+static void audio_set_blip_rates(double samplerate, double framerate)
 {
   /* Number of M-cycles executed per second. */
   /* All emulated chips are kept in sync by using a common oscillator (MCLOCK)            */
@@ -144,12 +144,36 @@ void audio_set_rate(int samplerate, double framerate)
     /* CDD core */
     cdd_init(samplerate);
   }
+}
+
+void audio_set_rate(int samplerate, double framerate)
+{
+  /* Initialize resampler rates */
+  audio_set_blip_rates(samplerate, framerate);
 
   /* Reinitialize internal rates */
   snd.sample_rate = samplerate;
   snd.frame_rate  = framerate;
 }
 
+void audio_set_rate_adjust(double ratio)
+{
+  /* Output samplerate is adjusted by a small fraction of its nominal value, e.g. to */
+  /* keep frontend audio buffer fill level constant (dynamic rate control). Only the */
+  /* resampling ratio is modified: Blip Buffers are not cleared and their fractional */
+  /* time offsets are preserved, so there is no discontinuity in output stream.      */
+  if (ratio > (1.0 + AUDIO_RATE_ADJUST_MAX))
+  {
+    ratio = 1.0 + AUDIO_RATE_ADJUST_MAX;
+  }
+  else if (ratio < (1.0 - AUDIO_RATE_ADJUST_MAX))
+  {
+    ratio = 1.0 - AUDIO_RATE_ADJUST_MAX;
+  }
+
+  audio_set_blip_rates(snd.sample_rate * ratio, snd.frame_rate);
+}
+
 void audio_reset(void)
 {
   int i;
@@ -173,11 +197,10 @@ void audio_reset(void)
 
 void audio_set_equalizer(void)
 {
-  init_3band_state(&eq[0],config.low_freq,config.high_freq,snd.sample_rate);
-  init_3band_state(&eq[1],config.low_freq,config.high_freq,snd.sample_rate);
-  eq[0].lg = eq[1].lg = (double)(config.lg) / 100.0;
-  eq[0].mg = eq[1].mg = (double)(config.mg) / 100.0;
-  eq[0].hg = eq[1].hg = (double)(config.hg) / 100.0;
+  init_3band_state(&eq,config.low_freq,config.high_freq,snd.sample_rate);
+  eq.lg = (float)(config.lg) / 100.0f;
+  eq.mg = (float)(config.mg) / 100.0f;
+  eq.hg = (float)(config.hg) / 100.0f;
 }
 
 void audio_shutdown(void)
@@ -196,8 +219,12 @@ void audio_shutdown(void)
 
 int audio_update(int16 *buffer)
 {
+  int size;
+
+  PROFILER_ENTER(PROF_AUDIO);
+
   /* run sound chips until end of frame */
-  int size = sound_update(mcycles_vdp);
+  size = sound_update(mcycles_vdp);
 
   /* Mega CD sound hardware enabled ? */
   if (snd.blips[1] && snd.blips[2])
@@ -218,11 +245,14 @@ int audio_update(int16 *buffer)
       blip_discard_samples_dirty(snd.blips[0], size);
       blip_discard_samples_dirty(snd.blips[1], size);
       blip_discard_samples_dirty(snd.blips[2], size);
+      PROFILER_LEAVE();
       return 0;
     }
 
     /* resample & mix FM/PSG, PCM & CD-DA streams to output buffer */
+    PROFILER_ENTER(PROF_BLIP);
     blip_mix_samples(snd.blips[0], snd.blips[1], snd.blips[2], buffer, size);
+    PROFILER_LEAVE();
   }
   else
   {
@@ -234,11 +264,14 @@ int audio_update(int16 *buffer)
     if (audio_hard_disable)
     {
       blip_discard_samples_dirty(snd.blips[0], size);
+      PROFILER_LEAVE();
       return 0;
     }
 
     /* resample FM/PSG mixed stream to output buffer */
+    PROFILER_ENTER(PROF_BLIP);
     blip_read_samples(snd.blips[0], buffer, size);
+    PROFILER_LEAVE();
   }
 
   /* Audio filtering */
@@ -280,23 +313,8 @@ int audio_update(int16 *buffer)
     }
     else if (config.filter & 2)
     {
-      do
-      {
-        /* 3 Band EQ */
-        l = do_3band(&eq[0],out[0]);
-        r = do_3band(&eq[1],out[1]);
-
-        /* clipping (16-bit samples) */
-        if (l > 32767) l = 32767;
-        else if (l < -32768) l = -32768;
-        if (r > 32767) r = 32767;
-        else if (r < -32768) r = -32768;
-
-        /* update sound buffer */
-        *out++ = l;
-        *out++ = r;
-      }
-      while (--samples);
+      /* 3 Band EQ (with 16-bit samples clipping) */
+      do_3band(&eq, out, samples);
     }
   }
 
@@ -318,6 +336,8 @@ int audio_update(int16 *buffer)
   error("%d samples returned\n\n",size);
 #endif
 
+  PROFILER_LEAVE();
+
   return size;
 }
 
@@ -348,6 +368,8 @@ void system_frame_gen(int do_skip)
   /* line counters */
   int start, end, line;
 
+  PROFILER_ENTER(PROF_SYSTEM);
+
   /* reset frame cycle counter */
   mcycles_vdp = 0;
 
@@ -624,7 +646,7 @@ void system_frame_gen(int do_skip)
     /* render scanline */
     if (!do_skip)
     {
-      render_line(line);
+      RENDER_LINE_ASYNC(line);
     }
 
     /* update 6-Buttons & Lightguns */
@@ -668,6 +690,9 @@ void system_frame_gen(int do_skip)
   }
   while (++line < bitmap.viewport.h);
 
+  /* wait for queued lines to be rendered */
+  RENDER_SYNC();
+
   /* check viewport changes */
   if (bitmap.viewport.w != bitmap.viewport.ow)
   {
@@ -679,6 +704,11 @@ void system_frame_gen(int do_skip)
   input_end_frame(mcycles_vdp);
   m68k.cycles -= mcycles_vdp;
   Z80.cycles -= mcycles_vdp;
+
+  /* blit queued NTSC filtered lines */
+  RENDER_FLUSH();
+
+  PROFILER_LEAVE();
 }
 
 void system_frame_scd(int do_skip)
@@ -686,6 +716,8 @@ void system_frame_scd(int do_skip)
   /* line counters */
   int start, end, line;
 
+  PROFILER_ENTER(PROF_SYSTEM);
+
   /* reset frame cycle counter */
   mcycles_vdp = 0;
   scd.cycles = 0;
@@ -951,7 +983,7 @@ void system_frame_scd(int do_skip)
     /* render scanline */
     if (!do_skip)
     {
-      render_line(line);
+      RENDER_LINE_ASYNC(line);
     }
     
     /* update 6-Buttons & Lightguns */
@@ -991,6 +1023,9 @@ void system_frame_scd(int do_skip)
   }
   while (++line < bitmap.viewport.h);
 
+  /* wait for queued lines to be rendered */
+  RENDER_SYNC();
+
   /* check viewport changes */
   if (bitmap.viewport.w != bitmap.viewport.ow)
   {
@@ -1003,6 +1038,11 @@ void system_frame_scd(int do_skip)
   input_end_frame(mcycles_vdp);
   m68k.cycles -= mcycles_vdp;
   Z80.cycles -= mcycles_vdp;
+
+  /* blit queued NTSC filtered lines */
+  RENDER_FLUSH();
+
+  PROFILER_LEAVE();
 }
 
 void system_frame_sms(int do_skip)
@@ -1010,6 +1050,8 @@ void system_frame_sms(int do_skip)
   /* line counter */
   int start, end, line;
 
+  PROFILER_ENTER(PROF_SYSTEM);
+
   /* reset frame cycle count */
   mcycles_vdp = 0;
 
@@ -1407,4 +1449,9 @@ void system_frame_sms(int do_skip)
   /* adjust timings for next frame */
   input_end_frame(mcycles_vdp);
   Z80.cycles -= mcycles_vdp;
+
+  /* blit queued NTSC filtered lines */
+  RENDER_FLUSH();
+
+  PROFILER_LEAVE();
 }
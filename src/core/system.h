@@ -69,12 +69,16 @@
 #define SMS_CYCLE_OFFSET  530 
 #define PBC_CYCLE_OFFSET  560 
 
+/* Maximal output samplerate adjustment (+/-0.5%) */
+#define AUDIO_RATE_ADJUST_MAX 0.005
+
 typedef struct
 {
   uint8 *data;      /* Bitmap data */
   int width;        /* Bitmap width */
   int height;       /* Bitmap height */
   int pitch;        /* Bitmap pitch */
+  int bpp;          /* Output pixel depth (32 = XRGB8888 with 15 or 16-bit rendering, 0 = rendering format) */
   struct
   {
     int x;          /* X offset of viewport within bitmap */
@@ -111,6 +115,7 @@ extern uint32 system_clock;
 /* Function prototypes */
 extern int audio_init(int samplerate, double framerate);
 extern void audio_set_rate(int samplerate, double framerate);
+extern void audio_set_rate_adjust(double ratio);
 extern void audio_reset(void);
 extern void audio_shutdown(void);
 extern int audio_update(int16 *buffer);
@@ -255,6 +255,8 @@ void vdp_init(void)
 void vdp_reset(void)
 {
   int i;
+
+  RENDER_SYNC();
   if (!reset_do_not_clear_buffers)
   {
     memset((char *)sat, 0, sizeof(sat));
@@ -463,6 +465,8 @@ int vdp_context_save(uint8 *state)
 {
   int bufferptr = 0;
 
+  RENDER_SYNC();
+
   save_param(sat, sizeof(sat));
   save_param(vram, sizeof(vram));
   save_param(cram, sizeof(cram));
@@ -494,6 +498,8 @@ int vdp_context_load(uint8 *state)
   uint8 *state_vram_ptr;
   /* Save number of dirty tiles before calls to register writes */
   int bg_list_index_save = bg_list_index;
+
+  RENDER_SYNC();
   /* Prevent register write code from invalidating the tile cache */
   do_not_invalidate_tile_cache = true;
 
@@ -620,6 +626,8 @@ void vdp_dma_update(unsigned int cycles)
 {
   unsigned int dma_cycles, dma_bytes;
 
+  RENDER_SYNC();
+
   /* DMA transfer rate (bytes per line) 
 
       DMA Mode      Width       Display      Transfer Count
@@ -706,7 +714,9 @@ void vdp_dma_update(unsigned int cycles)
     dma_length -= dma_bytes;
 
     /* Process DMA operation */
+    PROFILER_ENTER(PROF_DMA);
     dma_func[reg[23] >> 4](dma_bytes);
+    PROFILER_LEAVE();
 
     /* Check if DMA is finished */
     if (!dma_length)
@@ -736,6 +746,8 @@ void vdp_dma_update(unsigned int cycles)
 
 void vdp_68k_ctrl_w(unsigned int data)
 {
+  RENDER_SYNC();
+
   /* Check pending flag */
   if (pending == 0)
   {
@@ -884,6 +896,8 @@ void vdp_68k_ctrl_w(unsigned int data)
 /* Mega Drive VDP control port specific (MS compatibility mode) */
 void vdp_z80_ctrl_w(unsigned int data)
 {
+  RENDER_SYNC();
+
   switch (pending)
   {
     case 0:
@@ -1008,6 +1022,8 @@ void vdp_z80_ctrl_w(unsigned int data)
 /* Master System & Game Gear VDP control port specific */
 void vdp_sms_ctrl_w(unsigned int data)
 {
+  RENDER_SYNC();
+
   if (pending == 0)
   {
     /* Update address register LSB */
@@ -1131,6 +1147,8 @@ void vdp_sms_ctrl_w(unsigned int data)
 /* SG-1000 VDP (TMS99xx) control port specific */
 void vdp_tms_ctrl_w(unsigned int data)
 {
+  RENDER_SYNC();
+
   if (pending == 0)
   {
     /* Latch LSB */
@@ -1196,6 +1214,8 @@ unsigned int vdp_68k_ctrl_r(unsigned int cycles)
 {
   unsigned int temp;
 
+  RENDER_SYNC();
+
   /* Cycle-accurate VDP status read (adjust CPU time with current instruction execution time) */
   cycles += m68k_cycles();
 
@@ -1261,6 +1281,8 @@ unsigned int vdp_z80_ctrl_r(unsigned int cycles)
 {
   unsigned int temp;
 
+  RENDER_SYNC();
+
   /* Check if DMA busy flag is set (Mega Drive VDP specific) */
   if (status & 2)
   {
@@ -1451,6 +1473,8 @@ void vdp_test_w(unsigned int data)
 
 int vdp_68k_irq_ack(int int_level)
 {
+  RENDER_SYNC();
+
 #ifdef LOGVDP
   error("[%d(%d)][%d(%d)] INT Level %d ack (%x)\n", v_counter, (v_counter + (m68k.cycles - mcycles_vdp)/MCYCLES_PER_LINE)%lines_per_frame, m68k.cycles, m68k.cycles%MCYCLES_PER_LINE,int_level, m68k_get_reg(M68K_REG_PC));
 #endif
@@ -2333,6 +2357,8 @@ static void vdp_bus_w(unsigned int data)
 
 static void vdp_68k_data_w_m4(unsigned int data)
 {
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2425,6 +2451,8 @@ static void vdp_68k_data_w_m4(unsigned int data)
 
 static void vdp_68k_data_w_m5(unsigned int data)
 {
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2484,6 +2512,8 @@ static unsigned int vdp_68k_data_r_m4(void)
   /* VRAM address (interleaved format) */
   int index = ((addr << 1) & 0x3FC) | ((addr & 0x200) >> 8) | (addr & 0x3C00);
 
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2498,6 +2528,8 @@ static unsigned int vdp_68k_data_r_m5(void)
 {
   uint16 data = 0;
 
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2614,6 +2646,8 @@ static unsigned int vdp_68k_data_r_m5(void)
 
 static void vdp_z80_data_w_m4(unsigned int data)
 {
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2666,6 +2700,8 @@ static void vdp_z80_data_w_m4(unsigned int data)
 
 static void vdp_z80_data_w_m5(unsigned int data)
 {
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2780,6 +2816,8 @@ static unsigned int vdp_z80_data_r_m4(void)
   /* Read buffer */
   unsigned int data = fifo[0];
 
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2797,6 +2835,8 @@ static unsigned int vdp_z80_data_r_m5(void)
 {
   unsigned int data = 0;
 
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2850,6 +2890,8 @@ static unsigned int vdp_z80_data_r_m5(void)
 
 static void vdp_z80_data_w_ms(unsigned int data)
 {
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -2926,6 +2968,8 @@ static void vdp_z80_data_w_ms(unsigned int data)
 
 static void vdp_z80_data_w_gg(unsigned int data)
 {
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -3015,6 +3059,8 @@ static void vdp_z80_data_w_sg(unsigned int data)
   /* VRAM address */
   int index = addr & 0x3FFF;
 
+  RENDER_SYNC();
+
   /* Clear pending flag */
   pending = 0;
 
@@ -44,6 +44,17 @@
 #include "md_ntsc.h"
 #include "sms_ntsc.h"
 
+#ifdef USE_RENDER_THREAD
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+/* NTSC filtered lines are blitted by a pool of worker threads (NTSC filter is only supported for 15 or 16-bit pixels rendering) */
+#if defined(USE_15BPP_RENDERING) || defined(USE_16BPP_RENDERING)
+#define USE_NTSC_THREADS
+#endif
+#endif
+
 extern int8 reset_do_not_clear_buffers;
 
 #ifndef HAVE_NO_SPRITE_LIMIT
@@ -495,6 +506,60 @@ INLINE void WRITE_LONG(void *address, uint32 data)
 #define MAKE_PIXEL(r,g,b) ((0xff << 24) | (r) << 20 | (r) << 16 | (g) << 12 | (g)  << 8 | (b) << 4 | (b))
 #endif
 
+/* Runtime selectable 8:8:8 RGB output (15 or 16-bit pixels rendering only) */
+/* 5-bit or 6-bit color channels are expanded to 8-bit by replicating their high bits */
+#if defined(USE_15BPP_RENDERING) || defined(USE_16BPP_RENDERING)
+#define XRGB8888_OUTPUT
+#if defined(USE_15BPP_RENDERING)
+#define EXPAND_G(g) (((g) << 3) | ((g) >> 2))
+#else
+#define EXPAND_G(g) (((g) << 2) | ((g) >> 4))
+#endif
+#define MAKE_PIXEL_XRGB8888(pixel) ((0xff << 24) | \
+                                    ((GET_R(pixel) << 3) | (GET_R(pixel) >> 2)) << 16 | \
+                                    EXPAND_G(GET_G(pixel)) << 8 | \
+                                    ((GET_B(pixel) << 3) | (GET_B(pixel) >> 2)))
+
+/* LCD image persistence (ghosting) filter, applied on 8-bit color channels */
+#define RENDER_PIXEL_LCD_XRGB8888(in,out,table,rate) \
+{ \
+  uint32 pixel_out = table[*in++]; \
+  uint32 pixel_old = *out; \
+  if (pixel_out != pixel_old) \
+  { \
+    int r = (pixel_out >> 16) & 0xff; \
+    int g = (pixel_out >> 8) & 0xff; \
+    int b = pixel_out & 0xff; \
+    int r_decay = ((pixel_old >> 16) & 0xff) - r; \
+    int g_decay = ((pixel_old >> 8) & 0xff) - g; \
+    int b_decay = (pixel_old & 0xff) - b; \
+    if (r_decay > 0) r += (rate * r_decay) >> 8; \
+    if (g_decay > 0) g += (rate * g_decay) >> 8; \
+    if (b_decay > 0) b += (rate * b_decay) >> 8; \
+    pixel_out = (0xff << 24) | (r << 16) | (g << 8) | b; \
+  } \
+  *out++ = pixel_out; \
+}
+#endif
+
+/* Convert VDP pixel data to output pixel format (four pixels per iteration) */
+#define REMAP_PIXELS(in,out,table,width) \
+{ \
+  for (; width >= 4; width -= 4) \
+  { \
+    out[0] = table[in[0]]; \
+    out[1] = table[in[1]]; \
+    out[2] = table[in[2]]; \
+    out[3] = table[in[3]]; \
+    in += 4; \
+    out += 4; \
+  } \
+  while (width--) \
+  { \
+    *out++ = table[*in++]; \
+  } \
+}
+
 /* Window & Plane A clipping */
 static struct clip_t
 {
@@ -579,6 +644,13 @@ static uint8 lut[LUT_MAX][LUT_SIZE];
 static PIXEL_OUT_T pixel[0x100];
 static PIXEL_OUT_T pixel_lut[3][0x200];
 static PIXEL_OUT_T pixel_lut_m4[0x40];
+#ifdef XRGB8888_OUTPUT
+static uint32 pixel_xrgb8888[0x100];
+static unsigned int pixel_xrgb8888_update;
+
+/* Color palette modification counter */
+static unsigned int pixel_update = 1;
+#endif
 
 /* Background & Sprite line buffers */
 static uint8 linebuf[2][0x200];
@@ -603,6 +675,9 @@ static uint8 object_count[2];
 /* Sprite Collision Info */
 uint16 spr_col;
 
+/* Video output disabled (lines are not rendered, only sprites are processed) */
+int8 video_hard_disable = 0;
+
 /* Function pointers */
 void (*render_bg)(int line);
 void (*render_obj)(int line);
@@ -1120,6 +1195,10 @@ void color_update_m4(int index, unsigned int data)
       pixel[0xA0 | index] = data;
     }
   }
+
+#ifdef XRGB8888_OUTPUT
+  pixel_update++;
+#endif
 }
 
 void color_update_m5(int index, unsigned int data)
@@ -1148,6 +1227,10 @@ void color_update_m5(int index, unsigned int data)
     pixel[0x40 | index] = data;
     pixel[0x80 | index] = data;
   }
+
+#ifdef XRGB8888_OUTPUT
+  pixel_update++;
+#endif
 }
 
 
@@ -4564,6 +4647,80 @@ void update_bg_pattern_cache_m4(int index)
 }
 
 void update_bg_pattern_cache_m5(int index)
+{
+  int i;
+  uint8 y, bits;
+  uint32 *dst;
+  uint16 name;
+  uint32 bp, lo, hi;
+
+  for(i = 0; i < index; i++)
+  {
+    /* Get modified pattern name index */
+    name = bg_name_list[i];
+
+    /* Pattern cache base address (one pattern line = 8 bytes = 2 longwords) */
+    dst = (uint32 *)&bg_pattern_cache[name << 6];
+
+    /* Check modified lines */
+    for(y = 0, bits = bg_name_dirty[name]; bits; y++, bits >>= 1)
+    {
+      if(bits & 1)
+      {
+        /* Byteplane data (one pattern = 4 bytes) */
+        /* LIT_ENDIAN: byte0 (lsb) p2p3 p0p1 p6p7 p4p5 (msb) byte3 */
+        /* BIG_ENDIAN: byte0 (msb) p0p1 p2p3 p4p5 p6p7 (lsb) byte3 */
+        bp = *(uint32 *)&vram[(name << 5) | (y << 2)];
+
+        /* Expand each 4-bit pixel to one byte: pixels are extracted four at a time */
+        /* from each half of byteplane data, byte N receiving nibble N of each half */
+        lo = bp & 0xFFFF;
+        lo = (lo | (lo << 8)) & 0x00FF00FF;
+        lo = (lo | (lo << 4)) & 0x0F0F0F0F;
+        hi = bp >> 16;
+        hi = (hi | (hi << 8)) & 0x00FF00FF;
+        hi = (hi | (hi << 4)) & 0x0F0F0F0F;
+
+        /* Pattern cache data (one pattern = 8 bytes) */
+        /* byte0 <-> p0 p1 p2 p3 p4 p5 p6 p7 <-> byte7 (hflip = 0) */
+        /* byte0 <-> p7 p6 p5 p4 p3 p2 p1 p0 <-> byte7 (hflip = 1) */
+#ifdef LSB_FIRST
+        /* vflip=0, hflip=1 & vflip=1, hflip=1 */
+        dst[(0x20000 >> 2) | (y << 1)] = dst[(0x60000 >> 2) | ((y ^ 7) << 1)] = hi;
+        dst[(0x20000 >> 2) | (y << 1) | 1] = dst[(0x60000 >> 2) | ((y ^ 7) << 1) | 1] = lo;
+
+        /* byte-swapped for hflip = 0 */
+        lo = (lo >> 24) | ((lo >> 8) & 0xFF00) | ((lo << 8) & 0xFF0000) | (lo << 24);
+        hi = (hi >> 24) | ((hi >> 8) & 0xFF00) | ((hi << 8) & 0xFF0000) | (hi << 24);
+
+        /* vflip=0, hflip=0 & vflip=1, hflip=0 */
+        dst[(y << 1)] = dst[(0x40000 >> 2) | ((y ^ 7) << 1)] = lo;
+        dst[(y << 1) | 1] = dst[(0x40000 >> 2) | ((y ^ 7) << 1) | 1] = hi;
+#else
+        /* vflip=0, hflip=0 & vflip=1, hflip=0 */
+        dst[(y << 1)] = dst[(0x40000 >> 2) | ((y ^ 7) << 1)] = hi;
+        dst[(y << 1) | 1] = dst[(0x40000 >> 2) | ((y ^ 7) << 1) | 1] = lo;
+
+        /* byte-swapped for hflip = 1 */
+        lo = (lo >> 24) | ((lo >> 8) & 0xFF00) | ((lo << 8) & 0xFF0000) | (lo << 24);
+        hi = (hi >> 24) | ((hi >> 8) & 0xFF00) | ((hi << 8) & 0xFF0000) | (hi << 24);
+
+        /* vflip=0, hflip=1 & vflip=1, hflip=1 */
+        dst[(0x20000 >> 2) | (y << 1)] = dst[(0x60000 >> 2) | ((y ^ 7) << 1)] = lo;
+        dst[(0x20000 >> 2) | (y << 1) | 1] = dst[(0x60000 >> 2) | ((y ^ 7) << 1) | 1] = hi;
+#endif
+      }
+    }
+
+    /* Clear modified pattern flag */
+    bg_name_dirty[name] = 0;
+  }
+}
+
+
+#ifdef HAVE_SCALAR_PATTERN_CACHE
+/* original pixel by pixel implementation (used as reference by pattern cache benchmark) */
+void update_bg_pattern_cache_m5_scalar(int index)
 {
   int i;
   uint8 x, y, c;
@@ -4621,6 +4778,7 @@ void update_bg_pattern_cache_m5(int index)
     bg_name_dirty[name] = 0;
   }
 }
+#endif
 
 
 /*--------------------------------------------------------------------------*/
@@ -4719,6 +4877,9 @@ void render_reset(void)
 
     /* Clear color palettes */
     memset(pixel, 0, sizeof(pixel));
+#ifdef XRGB8888_OUTPUT
+    pixel_update++;
+#endif
 
     /* Clear pattern cache */
     memset((char *)bg_pattern_cache, 0, sizeof(bg_pattern_cache));
@@ -4733,8 +4894,61 @@ void render_reset(void)
 /* Line rendering functions                                                 */
 /*--------------------------------------------------------------------------*/
 
-void render_line(int line)
+/* Video output is disabled: background layers are not rendered and sprites are drawn over a */
+/* cleared line buffer, which is enough to update sprite overflow & collision status flags */
+/* since opaque sprite pixel marker (d7) is never set by background layers */
+static void draw_line_sprites(int line)
 {
+  /* Check display status */
+  if (reg[1] & 0x40)
+  {
+    /* Sprites on current line */
+    if (object_count[line & 1])
+    {
+      /* Update pattern cache */
+      if (bg_list_index)
+      {
+        update_bg_pattern_cache(bg_list_index);
+        bg_list_index = 0;
+      }
+
+      /* Clear line buffer */
+      memset(&linebuf[0][0], 0, bitmap.viewport.w + 0x40);
+    }
+
+    /* Render sprite layer (also updates sprite masking & SOVR flag) */
+    render_obj(line & 1);
+
+    /* Parse sprites for next line */
+    if (line < (bitmap.viewport.h - 1))
+    {
+      parse_satb(line);
+    }
+  }
+  else
+  {
+    /* Master System & Game Gear VDP specific */
+    if (system_hw < SYSTEM_MD)
+    {
+      /* Update SOVR flag */
+      status |= spr_ovr;
+      spr_ovr = 0;
+
+      /* Sprites are still parsed when display is disabled */
+      parse_satb(line);
+    }
+  }
+}
+
+static void draw_line(int line)
+{
+  /* Video output disabled */
+  if (video_hard_disable)
+  {
+    draw_line_sprites(line);
+    return;
+  }
+
   /* Check display status */
   if (reg[1] & 0x40)
   {
@@ -4794,12 +5008,483 @@ void render_line(int line)
   remap_line(line);
 }
 
+void render_line(int line)
+{
+  PROFILER_ENTER(PROF_RENDER);
+  draw_line(line);
+  PROFILER_LEAVE();
+}
+
 void blank_line(int line, int offset, int width)
 {
+  /* Video output disabled */
+  if (video_hard_disable)
+  {
+    return;
+  }
+
+  PROFILER_ENTER(PROF_RENDER);
   memset(&linebuf[0][0x20 + offset], 0x40, width);
   remap_line(line);
+  PROFILER_LEAVE();
+}
+
+#ifdef USE_RENDER_THREAD
+
+/* Mode 5 active display lines are queued by the emulation thread and rendered by a worker thread */
+/* A queued line only depends on VDP state, which cannot be modified before all queued lines have */
+/* been rendered since any VDP access from the emulation thread calls render_sync() first, so */
+/* output stays identical to serial rendering */
+
+/* Queued lines (power of two) */
+#define RENDER_QUEUE_SIZE 0x100
+
+/* Waiting threads yield the CPU after this number of polling loops */
+#define RENDER_SPIN_COUNT 1000
+
+/* Worker thread goes to sleep after this number of polling loops without any queued line */
+#define RENDER_IDLE_COUNT 100000
+
+#if defined(__i386__) || defined(__x86_64__)
+#define RENDER_PAUSE() __builtin_ia32_pause()
+#else
+#define RENDER_PAUSE()
+#endif
+
+#define RENDER_LOAD(x)    __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define RENDER_STORE(x,v) __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+
+static struct
+{
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int started;
+  int disabled;
+  int sleeping;
+  int quit;
+  unsigned int head;              /* number of queued lines (written by emulation thread) */
+  unsigned int tail;              /* number of rendered lines (written by worker thread) */
+  int line[RENDER_QUEUE_SIZE];
+} render_thread;
+
+static void *render_thread_main(void *arg)
+{
+  unsigned int tail = render_thread.tail;
+
+  while (1)
+  {
+    int spin = 0;
+
+    /* wait for queued lines */
+    while (RENDER_LOAD(render_thread.head) == tail)
+    {
+      if (RENDER_LOAD(render_thread.quit))
+      {
+        return NULL;
+      }
+
+      if (++spin < RENDER_SPIN_COUNT)
+      {
+        RENDER_PAUSE();
+        continue;
+      }
+
+      if (spin < RENDER_IDLE_COUNT)
+      {
+        sched_yield();
+        continue;
+      }
+
+      /* no more lines for a while (end of frame, emulation paused, ...) */
+      pthread_mutex_lock(&render_thread.mutex);
+      RENDER_STORE(render_thread.sleeping, 1);
+      while ((RENDER_LOAD(render_thread.head) == tail) && !RENDER_LOAD(render_thread.quit))
+      {
+        pthread_cond_wait(&render_thread.cond, &render_thread.mutex);
+      }
+      RENDER_STORE(render_thread.sleeping, 0);
+      pthread_mutex_unlock(&render_thread.mutex);
+      spin = 0;
+    }
+
+    draw_line(render_thread.line[tail & (RENDER_QUEUE_SIZE - 1)]);
+    RENDER_STORE(render_thread.tail, ++tail);
+  }
+}
+
+void render_line_async(int line)
+{
+  unsigned int head = render_thread.head;
+
+  /* only Mode 5 rendering has no side effect on emulation thread (Mode 4 sprite collision uses V counter) */
+  if (!(reg[1] & 0x04) || render_thread.disabled || video_hard_disable)
+  {
+    render_sync();
+    render_line(line);
+    return;
+  }
+
+  if (!render_thread.started)
+  {
+    /* both threads would compete for the same CPU */
+    if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+    {
+      render_thread.disabled = 1;
+      render_line(line);
+      return;
+    }
+
+    pthread_mutex_init(&render_thread.mutex, NULL);
+    pthread_cond_init(&render_thread.cond, NULL);
+    render_thread.head = render_thread.tail = head = 0;
+    render_thread.sleeping = render_thread.quit = 0;
+    if (pthread_create(&render_thread.thread, NULL, render_thread_main, NULL))
+    {
+      /* fallback to serial rendering */
+      pthread_cond_destroy(&render_thread.cond);
+      pthread_mutex_destroy(&render_thread.mutex);
+      render_thread.disabled = 1;
+      render_line(line);
+      return;
+    }
+    render_thread.started = 1;
+  }
+
+  /* wait for a free slot */
+  if ((head - RENDER_LOAD(render_thread.tail)) >= RENDER_QUEUE_SIZE)
+  {
+    render_sync();
+  }
+
+  render_thread.line[head & (RENDER_QUEUE_SIZE - 1)] = line;
+  RENDER_STORE(render_thread.head, head + 1);
+
+  /* wake up worker thread if needed */
+  if (RENDER_LOAD(render_thread.sleeping))
+  {
+    pthread_mutex_lock(&render_thread.mutex);
+    pthread_cond_signal(&render_thread.cond);
+    pthread_mutex_unlock(&render_thread.mutex);
+  }
+}
+
+void render_sync(void)
+{
+  /* wait until all queued lines have been rendered */
+  if (RENDER_LOAD(render_thread.tail) != render_thread.head)
+  {
+    int spin = 0;
+
+    PROFILER_ENTER(PROF_RENDER);
+    while (RENDER_LOAD(render_thread.tail) != render_thread.head)
+    {
+      if (++spin < RENDER_SPIN_COUNT)
+      {
+        RENDER_PAUSE();
+      }
+      else
+      {
+        sched_yield();
+      }
+    }
+    PROFILER_LEAVE();
+  }
+}
+
+#ifdef USE_NTSC_THREADS
+
+/* NTSC filtered lines are queued by remap_line() and blitted at end of frame by the emulation */
+/* thread and a pool of worker threads, each one filtering an interleaved subset of the lines */
+/* Lines are filtered from a copy of the pixel line buffer and of the color palette used at */
+/* the time they were remapped, so output stays identical to serial filtering */
+
+/* Maximal number of worker threads */
+#define NTSC_MAX_THREADS 4
+
+/* Maximal output line number (interlaced PAL) */
+#define NTSC_MAX_LINES 640
+
+/* Maximal number of color palette copies per frame */
+#define NTSC_MAX_PALETTES 32
+
+typedef struct
+{
+  uint8 src[0x200];               /* copy of pixel line buffer */
+  int width;
+  int palette;                    /* color palette copy index */
+  int md;                         /* H40 mode (md_ntsc) filter */
+  int queued;
+} ntsc_line_t;
+
+static struct
+{
+  pthread_t thread[NTSC_MAX_THREADS];
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int threads;
+  int started;
+  int disabled;
+  int quit;
+  unsigned int job;               /* incremented on each flush (protected by mutex) */
+  int pending;                    /* number of worker threads still filtering lines */
+  int count;                      /* number of queued lines */
+  int list[NTSC_MAX_LINES];       /* queued output lines */
+  ntsc_line_t *lines;
+  PIXEL_OUT_T (*palette)[0x100];
+  int palettes;
+  unsigned int palette_update;
+} ntsc_thread;
+
+static void ntsc_flush(void);
+
+static void ntsc_blit_lines(int first, int step)
+{
+  int i;
+  for (i = first; i < ntsc_thread.count; i += step)
+  {
+    int line = ntsc_thread.list[i];
+    ntsc_line_t *l = &ntsc_thread.lines[line];
+
+    if (l->md)
+    {
+      md_ntsc_blit(md_ntsc, ( MD_NTSC_IN_T const * )ntsc_thread.palette[l->palette], l->src, l->width, line);
+    }
+    else
+    {
+      sms_ntsc_blit(sms_ntsc, ( SMS_NTSC_IN_T const * )ntsc_thread.palette[l->palette], l->src, l->width, line);
+    }
+  }
+}
+
+static void *ntsc_thread_main(void *arg)
+{
+  int index = (int)(size_t)arg;
+  unsigned int job = 0;
+
+  while (1)
+  {
+    /* wait for next flush */
+    pthread_mutex_lock(&ntsc_thread.mutex);
+    while ((ntsc_thread.job == job) && !ntsc_thread.quit)
+    {
+      pthread_cond_wait(&ntsc_thread.cond, &ntsc_thread.mutex);
+    }
+    if (ntsc_thread.quit)
+    {
+      pthread_mutex_unlock(&ntsc_thread.mutex);
+      return NULL;
+    }
+    job = ntsc_thread.job;
+    pthread_mutex_unlock(&ntsc_thread.mutex);
+
+    ntsc_blit_lines(index, ntsc_thread.threads + 1);
+    __atomic_sub_fetch(&ntsc_thread.pending, 1, __ATOMIC_SEQ_CST);
+  }
 }
 
+static void ntsc_thread_start(void)
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+  /* worker threads would compete with emulation thread for the same CPU */
+  ntsc_thread.disabled = 1;
+  if (cpus < 2)
+  {
+    return;
+  }
+
+  ntsc_thread.lines = malloc(NTSC_MAX_LINES * sizeof(ntsc_line_t));
+  ntsc_thread.palette = malloc(NTSC_MAX_PALETTES * sizeof(*ntsc_thread.palette));
+  if (!ntsc_thread.lines || !ntsc_thread.palette)
+  {
+    free(ntsc_thread.lines);
+    free(ntsc_thread.palette);
+    ntsc_thread.lines = NULL;
+    ntsc_thread.palette = NULL;
+    return;
+  }
+  memset(ntsc_thread.lines, 0, NTSC_MAX_LINES * sizeof(ntsc_line_t));
+
+  pthread_mutex_init(&ntsc_thread.mutex, NULL);
+  pthread_cond_init(&ntsc_thread.cond, NULL);
+  ntsc_thread.job = 0;
+  ntsc_thread.quit = 0;
+  ntsc_thread.count = 0;
+  ntsc_thread.palettes = 0;
+
+  for (ntsc_thread.threads = 0; ntsc_thread.threads < (cpus - 1) && ntsc_thread.threads < NTSC_MAX_THREADS; ntsc_thread.threads++)
+  {
+    if (pthread_create(&ntsc_thread.thread[ntsc_thread.threads], NULL, ntsc_thread_main, (void *)(size_t)(ntsc_thread.threads + 1)))
+    {
+      break;
+    }
+  }
+
+  ntsc_thread.started = 1;
+  ntsc_thread.disabled = (ntsc_thread.threads == 0);
+}
+
+static void ntsc_thread_stop(void)
+{
+  int i;
+
+  pthread_mutex_lock(&ntsc_thread.mutex);
+  ntsc_thread.quit = 1;
+  pthread_cond_broadcast(&ntsc_thread.cond);
+  pthread_mutex_unlock(&ntsc_thread.mutex);
+
+  for (i = 0; i < ntsc_thread.threads; i++)
+  {
+    pthread_join(ntsc_thread.thread[i], NULL);
+  }
+
+  pthread_cond_destroy(&ntsc_thread.cond);
+  pthread_mutex_destroy(&ntsc_thread.mutex);
+  free(ntsc_thread.lines);
+  free(ntsc_thread.palette);
+  ntsc_thread.lines = NULL;
+  ntsc_thread.palette = NULL;
+  ntsc_thread.threads = 0;
+  ntsc_thread.started = 0;
+}
+
+static int ntsc_queue_line(uint8 *src, int width, int line)
+{
+  ntsc_line_t *l;
+
+  if (!ntsc_thread.started)
+  {
+    if (ntsc_thread.disabled)
+    {
+      return 0;
+    }
+    ntsc_thread_start();
+  }
+
+  if (ntsc_thread.disabled || (line >= NTSC_MAX_LINES) || (width > 0x200))
+  {
+    return 0;
+  }
+
+  l = &ntsc_thread.lines[line];
+
+  /* line already queued with a different width: previous output must not be fully overwritten */
+  if (l->queued && (l->width != width))
+  {
+    ntsc_flush();
+  }
+
+  /* copy current color palette if modified since last copy */
+  if (!ntsc_thread.palettes || (ntsc_thread.palette_update != pixel_update))
+  {
+    if (ntsc_thread.palettes == NTSC_MAX_PALETTES)
+    {
+      ntsc_flush();
+    }
+    memcpy(ntsc_thread.palette[ntsc_thread.palettes++], pixel, sizeof(pixel));
+    ntsc_thread.palette_update = pixel_update;
+  }
+
+  memcpy(l->src, src, width);
+  l->width = width;
+  l->palette = ntsc_thread.palettes - 1;
+  l->md = reg[12] & 0x01;
+
+  if (!l->queued)
+  {
+    l->queued = 1;
+    ntsc_thread.list[ntsc_thread.count++] = line;
+  }
+
+  return 1;
+}
+
+static void ntsc_flush(void)
+{
+  int i;
+
+  /* start worker threads */
+  pthread_mutex_lock(&ntsc_thread.mutex);
+  RENDER_STORE(ntsc_thread.pending, ntsc_thread.threads);
+  ntsc_thread.job++;
+  pthread_cond_broadcast(&ntsc_thread.cond);
+  pthread_mutex_unlock(&ntsc_thread.mutex);
+
+  /* emulation thread filters its own subset of lines */
+  ntsc_blit_lines(0, ntsc_thread.threads + 1);
+
+  /* wait for worker threads */
+  if (RENDER_LOAD(ntsc_thread.pending))
+  {
+    int spin = 0;
+    while (RENDER_LOAD(ntsc_thread.pending))
+    {
+      if (++spin < RENDER_SPIN_COUNT)
+      {
+        RENDER_PAUSE();
+      }
+      else
+      {
+        sched_yield();
+      }
+    }
+  }
+
+  for (i = 0; i < ntsc_thread.count; i++)
+  {
+    ntsc_thread.lines[ntsc_thread.list[i]].queued = 0;
+  }
+  ntsc_thread.count = 0;
+  ntsc_thread.palettes = 0;
+}
+
+#endif /* USE_NTSC_THREADS */
+
+void render_flush(void)
+{
+#ifdef USE_NTSC_THREADS
+  if (ntsc_thread.count)
+  {
+    PROFILER_ENTER(PROF_RENDER);
+    ntsc_flush();
+    PROFILER_LEAVE();
+  }
+#endif
+}
+
+void render_shutdown(void)
+{
+  if (render_thread.started)
+  {
+    render_sync();
+
+    pthread_mutex_lock(&render_thread.mutex);
+    RENDER_STORE(render_thread.quit, 1);
+    pthread_cond_signal(&render_thread.cond);
+    pthread_mutex_unlock(&render_thread.mutex);
+
+    pthread_join(render_thread.thread, NULL);
+    pthread_cond_destroy(&render_thread.cond);
+    pthread_mutex_destroy(&render_thread.mutex);
+    render_thread.started = 0;
+  }
+
+  render_thread.disabled = 0;
+
+#ifdef USE_NTSC_THREADS
+  if (ntsc_thread.started)
+  {
+    ntsc_flush();
+    ntsc_thread_stop();
+  }
+
+  ntsc_thread.disabled = 0;
+#endif
+}
+
+#endif /* USE_RENDER_THREAD */
+
 void remap_line(int line)
 {
   /* Line width */
@@ -4820,10 +5505,50 @@ void remap_line(int line)
     line = (line * 2) + odd_frame;
   }
 
+#ifdef XRGB8888_OUTPUT
+  /* 32-bit output (NTSC Filter is not supported) */
+  if (bitmap.bpp == 32)
+  {
+    uint32 *dst = ((uint32 *)&bitmap.data[(line * bitmap.pitch)]);
+
+    /* Update output pixel data look-up table when color palette has been modified */
+    if (pixel_xrgb8888_update != pixel_update)
+    {
+      int i;
+      for (i = 0; i < 0x100; i++)
+      {
+        pixel_xrgb8888[i] = MAKE_PIXEL_XRGB8888(pixel[i]);
+      }
+      pixel_xrgb8888_update = pixel_update;
+    }
+
+    if (config.lcd)
+    {
+      do
+      {
+        RENDER_PIXEL_LCD_XRGB8888(src,dst,pixel_xrgb8888,config.lcd);
+      }
+      while (--width);
+    }
+    else
+    {
+      REMAP_PIXELS(src,dst,pixel_xrgb8888,width);
+    }
+  }
+  else
+#endif
 #if defined(USE_15BPP_RENDERING) || defined(USE_16BPP_RENDERING)
   /* NTSC Filter (only supported for 15 or 16-bit pixels rendering) */
   if (config.ntsc)
   {
+#ifdef USE_NTSC_THREADS
+    /* Filtering is deferred to end of frame when possible */
+    if (ntsc_queue_line(src, width, line))
+    {
+      return;
+    }
+#endif
+
     if (reg[12] & 0x01)
     {
       md_ntsc_blit(md_ntsc, ( MD_NTSC_IN_T const * )pixel, src, width, line);
@@ -4851,11 +5576,7 @@ void remap_line(int line)
     }
     else
     {
-      do
-      {
-        *dst++ = pixel[*src++];
-      }
-      while (--width);
+      REMAP_PIXELS(src,dst,pixel,width);
     }
  #endif
   }
@@ -83,24 +83,30 @@
 /* Simulates (roughly) the slow decay response time of passive-matrix LCD */
 /* Rate value is formatted as 0.8 fixed-point integer (between 0.0 and 0.99609375), a higher value meaning a slower decay */
 /* Required for proper display of some effects in a few Game Gear games (James Pond 3, Power Drift, Super Monaco GP II,...) */
+/* Unchanged pixels have no decay and are copied as is */
 #define RENDER_PIXEL_LCD(in,out,table,rate) \
 { \
   PIXEL_OUT_T pixel_out = table[*in++]; \
   PIXEL_OUT_T pixel_old  = *out; \
-  uint8 r = GET_R(pixel_out); \
-  uint8 g = GET_G(pixel_out); \
-  uint8 b = GET_B(pixel_out); \
-  int r_decay = GET_R(pixel_old) - r; \
-  int g_decay = GET_G(pixel_old) - g; \
-  int b_decay = GET_B(pixel_old) - b; \
-  if (r_decay > 0) r += (rate * r_decay) >> 8; \
-  if (g_decay > 0) g += (rate * g_decay) >> 8; \
-  if (b_decay > 0) b += (rate * b_decay) >> 8; \
-  *out++ = PIXEL(r,g,b); \
+  if (pixel_out != pixel_old) \
+  { \
+    uint8 r = GET_R(pixel_out); \
+    uint8 g = GET_G(pixel_out); \
+    uint8 b = GET_B(pixel_out); \
+    int r_decay = GET_R(pixel_old) - r; \
+    int g_decay = GET_G(pixel_old) - g; \
+    int b_decay = GET_B(pixel_old) - b; \
+    if (r_decay > 0) r += (rate * r_decay) >> 8; \
+    if (g_decay > 0) g += (rate * g_decay) >> 8; \
+    if (b_decay > 0) b += (rate * b_decay) >> 8; \
+    pixel_out = PIXEL(r,g,b); \
+  } \
+  *out++ = pixel_out; \
 }
 
 /* Global variables */
 extern uint16 spr_col;
+extern int8 video_hard_disable;
 
 /* Function prototypes */
 extern void render_init(void);
@@ -133,6 +139,9 @@ extern void parse_satb_m4(int line);
 extern void parse_satb_m5(int line);
 extern void update_bg_pattern_cache_m4(int index);
 extern void update_bg_pattern_cache_m5(int index);
+#ifdef HAVE_SCALAR_PATTERN_CACHE
+extern void update_bg_pattern_cache_m5_scalar(int index);
+#endif
 extern void color_update_m4(int index, unsigned int data);
 extern void color_update_m5(int index, unsigned int data);
 
@@ -142,4 +151,19 @@ extern void (*render_obj)(int line);
 extern void (*parse_satb)(int line);
 extern void (*update_bg_pattern_cache)(int index);
 
+/* Threaded rendering */
+#ifdef USE_RENDER_THREAD
+extern void render_line_async(int line);
+extern void render_sync(void);
+extern void render_flush(void);
+extern void render_shutdown(void);
+#define RENDER_LINE_ASYNC(line) render_line_async(line)
+#define RENDER_SYNC() render_sync()
+#define RENDER_FLUSH() render_flush()
+#else
+#define RENDER_LINE_ASYNC(line) render_line(line)
+#define RENDER_SYNC()
+#define RENDER_FLUSH()
+#endif
+
 #endif /* _RENDER_H_ */
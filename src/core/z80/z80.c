@@ -3419,19 +3419,23 @@ void z80_reset(void)
  ****************************************************************************/
 void z80_run(unsigned int cycles)
 {
+  PROFILER_ENTER(PROF_Z80);
+
   while( Z80.cycles < cycles )
   {
     /* check for IRQs before each instruction */
     if (Z80.irq_state && IFF1 && !Z80.after_ei)
     {
       take_interrupt();
-      if (Z80.cycles >= cycles) return;
+      if (Z80.cycles >= cycles) break;
     }
 
     Z80.after_ei = FALSE;
     R++;
     EXEC_INLINE(op,ROP());
   }
+
+  PROFILER_LEAVE();
 } 
 
 /****************************************************************************
@@ -124,6 +124,9 @@ char CD_BRAM_JP[256];
 char CD_BRAM_US[256];
 char CD_BRAM_EU[256];
 char CART_BRAM[256];
+#ifdef USE_CD_CACHE
+char CD_CACHE_DIR[256];
+#endif
 
 static int vwidth;
 static int vheight;
@@ -141,7 +144,14 @@ static uint8_t brm_format[0x40] =
 static bool is_running = 0;
 static uint8_t temp[0x10000];
 static int16 soundbuffer[3068];
+#ifdef USE_32BPP_RENDERING
+static uint32_t bitmap_data_[720 * 576];
+#else
 static uint16_t bitmap_data_[720 * 576];
+#endif
+static uint32_t *bitmap_data32_ = NULL;  /* XRGB8888 output buffer, only allocated when enabled */
+static bool use_xrgb8888 = false;
+static enum retro_pixel_format pixel_format = RETRO_PIXEL_FORMAT_0RGB1555;
 
 static bool restart_eq = false;
 
@@ -932,8 +942,18 @@ static void draw_cursor(int16_t x, int16_t y, uint16_t color)
 {
    int i;
 
+   /* framebuffer pitch (in pixels) */
+   int stride = bitmap.pitch / ((bitmap.bpp == 32) ? 4 : 2);
+
    /* crosshair center position */   
-   uint16_t *ptr = (uint16_t *)bitmap.data + ((bitmap.viewport.y + y) * bitmap.width) + x + bitmap.viewport.x;
+   int offset = ((bitmap.viewport.y + y) * stride) + x + bitmap.viewport.x;
+   uint16_t *ptr = (uint16_t *)bitmap.data + offset;
+   uint32_t *ptr32 = (uint32_t *)bitmap.data + offset;
+
+   /* RGB565 crosshair color expanded to XRGB8888 */
+   uint32_t color32 = ((((color >> 11) & 0x1f) * 255 / 31) << 16) |
+                      ((((color >> 5) & 0x3f) * 255 / 63) << 8) |
+                      ((color & 0x1f) * 255 / 31);
 
    /* default crosshair dimension */
    int x_start = x - 3;
@@ -952,10 +972,20 @@ static void draw_cursor(int16_t x, int16_t y, uint16_t color)
    if (y_end >= (bitmap.viewport.h + bitmap.viewport.y)) y_end = bitmap.viewport.h + bitmap.viewport.y - 1;
 
    /* draw crosshair */
-   for (i = (x_start - x); i <= (x_end - x); i++)
-      ptr[i] = (i & 1) ? color : 0xffff;
-   for (i = (y_start - y); i <= (y_end - y); i++)
-      ptr[i * bitmap.width] = (i & 1) ? color : 0xffff;
+   if (bitmap.bpp == 32)
+   {
+      for (i = (x_start - x); i <= (x_end - x); i++)
+         ptr32[i] = (i & 1) ? color32 : 0xffffff;
+      for (i = (y_start - y); i <= (y_end - y); i++)
+         ptr32[i * stride] = (i & 1) ? color32 : 0xffffff;
+   }
+   else
+   {
+      for (i = (x_start - x); i <= (x_end - x); i++)
+         ptr[i] = (i & 1) ? color : 0xffff;
+      for (i = (y_start - y); i <= (y_end - y); i++)
+         ptr[i * stride] = (i & 1) ? color : 0xffff;
+   }
 }
 
 static void init_bitmap(void)
@@ -963,8 +993,41 @@ static void init_bitmap(void)
    memset(&bitmap, 0, sizeof(bitmap));
    bitmap.width      = 720;
    bitmap.height     = 576;
-   bitmap.pitch      = 720 * 2;
-   bitmap.data       = (uint8_t *)bitmap_data_;
+   bitmap.pitch      = 720 * (use_xrgb8888 ? 4 : 2);
+   bitmap.bpp        = use_xrgb8888 ? 32 : 0;
+   bitmap.data       = use_xrgb8888 ? (uint8_t *)bitmap_data32_ : (uint8_t *)bitmap_data_;
+}
+
+static void acquire_frontend_framebuffer(void)
+{
+   struct retro_framebuffer fb;
+
+   /* LCD ghosting filter and double field interlaced output need previous frame pixels */
+   if (config.lcd || (interlaced && config.render))
+      return;
+
+   memset(&fb, 0, sizeof(fb));
+   fb.width        = bitmap.width;
+   fb.height       = bitmap.height;
+   fb.access_flags = RETRO_MEMORY_ACCESS_WRITE;
+
+   if (!environ_cb(RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER, &fb) || !fb.data)
+      return;
+
+   /* framebuffer must match internal bitmap format and dimensions */
+   if ((fb.format != pixel_format) || (fb.pitch < (size_t)(720 * (use_xrgb8888 ? 4 : 2))))
+      return;
+
+   /* render current frame directly into frontend framebuffer */
+   bitmap.data  = (uint8_t *)fb.data;
+   bitmap.pitch = fb.pitch;
+}
+
+static void release_frontend_framebuffer(void)
+{
+   /* frontend framebuffer is only valid during current retro_run() call */
+   bitmap.data  = use_xrgb8888 ? (uint8_t *)bitmap_data32_ : (uint8_t *)bitmap_data_;
+   bitmap.pitch = 720 * (use_xrgb8888 ? 4 : 2);
 }
 
 static void config_default(void)
@@ -1784,7 +1847,8 @@ static void check_variables(bool first_run)
   {
     orig_value = config.ntsc;
 
-    if (!var.value || !strcmp(var.value, "disabled"))
+    /* NTSC filter only outputs 15 or 16-bit pixels */
+    if (!var.value || !strcmp(var.value, "disabled") || use_xrgb8888)
       config.ntsc = 0;
     else if (var.value && !strcmp(var.value, "monochrome"))
     {
@@ -3252,12 +3316,46 @@ bool retro_load_game(const struct retro_game_info *info)
       }
    }
 
+#if defined(USE_15BPP_RENDERING) || defined(USE_16BPP_RENDERING)
+   {
+      struct retro_variable var;
+      var.key   = "genesis_plus_gx_pixel_format";
+      var.value = NULL;
+      use_xrgb8888 = false;
+
+      if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value && !strcmp(var.value, "32-bit"))
+      {
+         unsigned xrgb8888 = RETRO_PIXEL_FORMAT_XRGB8888;
+         if (!bitmap_data32_)
+            bitmap_data32_ = (uint32_t *)malloc(720 * 576 * sizeof(uint32_t));
+         if (bitmap_data32_ && environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &xrgb8888))
+         {
+            use_xrgb8888 = true;
+            pixel_format = RETRO_PIXEL_FORMAT_XRGB8888;
+            if (log_cb)
+               log_cb(RETRO_LOG_INFO, "Frontend supports XRGB8888 - will use 32-bit output.\n");
+         }
+      }
+
+      /* 32-bit output buffer is not needed */
+      if (!use_xrgb8888 && bitmap_data32_)
+      {
+         free(bitmap_data32_);
+         bitmap_data32_ = NULL;
+      }
+   }
+#endif
+
 #ifdef FRONTEND_SUPPORTS_RGB565
+   if (!use_xrgb8888)
    {
       unsigned rgb565 = RETRO_PIXEL_FORMAT_RGB565;
       if(environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &rgb565))
+      {
+         pixel_format = RETRO_PIXEL_FORMAT_RGB565;
          if (log_cb)
             log_cb(RETRO_LOG_INFO, "Frontend supports RGB565 - will use that instead of XRGB1555.\n");
+      }
    }
 #endif
 
@@ -3293,6 +3391,11 @@ bool retro_load_game(const struct retro_game_info *info)
    fill_pathname_join(CD_BIOS_EU, dir, "bios_CD_E.bin", sizeof(CD_BIOS_EU));
    fill_pathname_join(CD_BIOS_US, dir, "bios_CD_U.bin", sizeof(CD_BIOS_US));
    fill_pathname_join(CD_BIOS_JP, dir, "bios_CD_J.bin", sizeof(CD_BIOS_JP));
+#ifdef USE_CD_CACHE
+   fill_pathname_join(CD_CACHE_DIR, save_dir, "genesis_plus_gx_cdcache", sizeof(CD_CACHE_DIR));
+   if (!path_mkdir(CD_CACHE_DIR))
+      CD_CACHE_DIR[0] = 0;
+#endif
  
    check_variables(true);
 
@@ -3464,6 +3567,11 @@ error:
       free(md_ntsc);
    md_ntsc   = NULL;
 
+   if (bitmap_data32_)
+      free(bitmap_data32_);
+   bitmap_data32_ = NULL;
+   use_xrgb8888   = false;
+
    system_hw = 0;
 
    return false;
@@ -3495,6 +3603,34 @@ void retro_unload_game(void)
    if (system_hw == SYSTEM_MCD)
       bram_save();
 
+#ifdef USE_PROFILER
+   {
+      const t_profile *prof = profiler_get_total();
+      if (prof->frames)
+      {
+         for (i=0; i<PROF_MAX; i++)
+         {
+            log_cb(RETRO_LOG_INFO, "[genplus]: %-8s %8.1f us/frame %8.1f calls/frame\n", profiler_get_name(i),
+               (prof->time[i] / 1000.0) / prof->frames, (double)prof->calls[i] / prof->frames);
+         }
+      }
+      profiler_reset();
+   }
+#endif
+
+#ifdef USE_RENDER_THREAD
+   render_shutdown();
+#endif
+
+#ifdef USE_FM_THREAD
+   sound_shutdown();
+#endif
+
+#ifdef USE_CD_CACHE
+   /* stop CD image cache file creation */
+   cdd_unload();
+#endif
+
    audio_shutdown();
 
    if (md_ntsc)
@@ -3504,6 +3640,11 @@ void retro_unload_game(void)
       free(sms_ntsc);
    sms_ntsc  = NULL;
 
+   if (bitmap_data32_)
+      free(bitmap_data32_);
+   bitmap_data32_ = NULL;
+   use_xrgb8888   = false;
+
    system_hw = 0;
 }
 
@@ -3666,6 +3807,7 @@ void retro_run(void)
       bool videoEnabled = 0 != (result & 1);
       bool hardDisableAudio = 0 != (result & 8);
       do_skip = !videoEnabled;
+      video_hard_disable = !videoEnabled;
       if (audio_hard_disable != hardDisableAudio)
       {
         audio_hard_disable = hardDisableAudio;
@@ -3675,6 +3817,7 @@ void retro_run(void)
    else
    {
       do_skip = false;
+      video_hard_disable = false;
       audio_hard_disable = false;
    }
 
@@ -3715,6 +3858,12 @@ void retro_run(void)
     update_audio_latency = false;
   }
 
+   /* zero-copy video output when supported by frontend */
+   if (!do_skip)
+   {
+      acquire_frontend_framebuffer();
+   }
+
    if (system_hw == SYSTEM_MCD)
    {
       system_frame_scd(do_skip);
@@ -3783,14 +3932,20 @@ void retro_run(void)
 
    if (!do_skip)
    {
-        video_cb(bitmap.data + bmdoffset, vwidth - vwoffset, vheight, 720 * 2);	
+        video_cb(bitmap.data + bmdoffset * (use_xrgb8888 ? 2 : 1), vwidth - vwoffset, vheight, bitmap.pitch);
    }
    else
    {
-        video_cb(NULL, vwidth - vwoffset, vheight, 720 * 2);
+        video_cb(NULL, vwidth - vwoffset, vheight, bitmap.pitch);
    }
 
+   release_frontend_framebuffer();
+
    audio_cb(soundbuffer, audio_update(soundbuffer));
+
+#ifdef USE_PROFILER
+   profiler_frame();
+#endif
 }
 
 #undef  CHUNKSIZE
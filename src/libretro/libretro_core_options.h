@@ -283,6 +283,20 @@ struct retro_core_option_v2_definition option_defs_us[] = {
       },
       "disabled"
    },
+   {
+      "genesis_plus_gx_pixel_format",
+      "Output Pixel Format (Restart Required)",
+      NULL,
+      "Pixel format of the video output. '32-bit' outputs XRGB8888 pixels directly, which avoids an additional conversion by frontends working in 32-bit color. The Blargg NTSC filter is only available with '16-bit'.",
+      NULL,
+      "video",
+      {
+         { "16-bit", NULL },
+         { "32-bit", NULL },
+         { NULL, NULL },
+      },
+      "16-bit"
+   },
    {
       "genesis_plus_gx_lcd_filter",
       "LCD Ghosting Filter",
@@ -157,6 +157,11 @@ extern char CD_BIOS_JP[256];
 extern char MS_BIOS_US[256];
 extern char MS_BIOS_EU[256];
 extern char MS_BIOS_JP[256];
+#ifdef USE_CD_CACHE
+extern char CD_CACHE_DIR[256];
+#define cdCacheRename       filestream_rename
+#define cdCacheRemove       filestream_delete
+#endif
 
 extern void osd_input_update(void);
 extern int load_archive(char *filename, unsigned char *buffer, int maxsize, char *extension);
@@ -165,8 +170,10 @@ extern void ROMCheatUpdate(void);
 #ifndef cdStream
 #define cdStream            RFILE
 #define cdStreamOpen(fname) rfopen(fname, "rb")
+#define cdStreamCreate(fname) rfopen(fname, "wb")
 #define cdStreamClose       rfclose
 #define cdStreamRead        rfread
+#define cdStreamWrite       rfwrite
 #define cdStreamSeek        rfseek
 #define cdStreamTell        rftell
 #define cdStreamGets        rfgets
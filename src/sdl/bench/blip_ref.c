@@ -0,0 +1,30 @@
+/*
+ *  blip_ref.c
+ *
+ *  Reference blip_buf implementation (SIMD code disabled) for blip_buf conformance test
+ *
+ *  All public functions are renamed with a blip_ref_ prefix so that it can be linked
+ *  together with default blip_buf implementation.
+ */
+
+#define BLIP_NO_SIMD
+
+#define blip_new                  blip_ref_new
+#define blip_set_rates            blip_ref_set_rates
+#define blip_clear                blip_ref_clear
+#define blip_add_delta            blip_ref_add_delta
+#define blip_add_delta_fast       blip_ref_add_delta_fast
+#define blip_add_levels_fast      blip_ref_add_levels_fast
+#define blip_clocks_needed        blip_ref_clocks_needed
+#define blip_end_frame            blip_ref_end_frame
+#define blip_samples_avail        blip_ref_samples_avail
+#define blip_discard_samples_dirty blip_ref_discard_samples_dirty
+#define blip_read_samples         blip_ref_read_samples
+#define blip_mix_samples          blip_ref_mix_samples
+#define blip_delete               blip_ref_delete
+#define blip_save_buffer_state    blip_ref_save_buffer_state
+#define blip_load_buffer_state    blip_ref_load_buffer_state
+#define blip_new_buffer_state     blip_ref_new_buffer_state
+#define blip_delete_buffer_state  blip_ref_delete_buffer_state
+
+#include "blip_buf.c"
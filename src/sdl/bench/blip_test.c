@@ -0,0 +1,182 @@
+/*
+ *  blip_test.c
+ *
+ *  blip_buf SIMD conformance test
+ *
+ *  Feeds default blip_buf implementation and reference implementation (blip_ref.c,
+ *  compiled with BLIP_NO_SIMD) with the same random stereo level changes, using
+ *  various clock and sample rates, and checks that blip_read_samples() outputs are
+ *  identical.
+ *
+ *  usage: blip_test [-s seed] [-n frames]
+ *
+ *  -s seed   : random seed (default 1)
+ *  -n frames : number of frames per clock & sample rates pair (default 500)
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "blip_buf.h"
+
+/* reference implementation (blip_ref.c) */
+blip_t* blip_ref_new( int sample_count );
+void blip_ref_set_rates( blip_t*, double clock_rate, double sample_rate );
+void blip_ref_add_delta( blip_t*, unsigned time, int delta_l, int delta_r );
+void blip_ref_add_delta_fast( blip_t*, unsigned time, int delta_l, int delta_r );
+int blip_ref_clocks_needed( const blip_t*, int sample_count );
+void blip_ref_end_frame( blip_t*, unsigned clock_duration );
+int blip_ref_samples_avail( const blip_t* );
+int blip_ref_read_samples( blip_t*, short out [], int count);
+void blip_ref_delete( blip_t* );
+
+/* master clocks (MD NTSC & PAL, SMS NTSC & PAL) */
+static const double clock_rates[] = { 53693175.0, 53203424.0, 3579545.0 * 15.0, 3546893.0 * 15.0 };
+
+/* output sample rates */
+static const double sample_rates[] = { 22050.0, 32000.0, 44100.0, 48000.0, 96000.0 };
+
+#define BUFFER_SIZE 4800
+
+static short out_ref[BUFFER_SIZE * 2];
+static short out_new[BUFFER_SIZE * 2];
+
+/* level range is limited to prevent buffer overflow with consecutive maximal level changes */
+static int random_level(void)
+{
+  switch (rand() % 4)
+  {
+    case 0:
+      /* full range */
+      return (rand() % 0x8000) - 0x4000;
+    case 1:
+      /* maximal levels */
+      return (rand() & 1) ? 0x3fff : -0x4000;
+    default:
+      /* small changes */
+      return (rand() % 0x400) - 0x200;
+  }
+}
+
+static int test_rates(double clock_rate, double sample_rate, int frames)
+{
+  int i;
+  int prev_l = 0, prev_r = 0;
+  blip_t *ref = blip_ref_new(BUFFER_SIZE);
+  blip_t *blip = blip_new(BUFFER_SIZE);
+
+  blip_ref_set_rates(ref, clock_rate, sample_rate);
+  blip_set_rates(blip, clock_rate, sample_rate);
+
+  for (i = 0; i < frames; i++)
+  {
+    int samples = 1 + rand() % blip_max_frame;
+    int clocks = blip_clocks_needed(blip, samples);
+    int deltas = rand() % (samples + 1);
+    unsigned int time = 0;
+
+    if (clocks != blip_ref_clocks_needed(ref, samples))
+    {
+      printf("frame %d: %d clocks needed instead of %d\n", i, clocks, blip_ref_clocks_needed(ref, samples));
+      break;
+    }
+
+    while (deltas-- > 0)
+    {
+      int l = random_level();
+      int r = (rand() % 4) ? random_level() : l;
+
+      time += rand() % (2 * (clocks - time) / (deltas + 1) + 1);
+      if (time >= (unsigned int)clocks)
+      {
+        break;
+      }
+
+      if (rand() % 8)
+      {
+        blip_ref_add_delta(ref, time, l - prev_l, r - prev_r);
+        blip_add_delta(blip, time, l - prev_l, r - prev_r);
+      }
+      else
+      {
+        blip_ref_add_delta_fast(ref, time, l - prev_l, r - prev_r);
+        blip_add_delta_fast(blip, time, l - prev_l, r - prev_r);
+      }
+
+      prev_l = l;
+      prev_r = r;
+    }
+
+    blip_ref_end_frame(ref, clocks);
+    blip_end_frame(blip, clocks);
+
+    if (blip_samples_avail(blip) != blip_ref_samples_avail(ref))
+    {
+      printf("frame %d: %d samples available instead of %d\n", i, blip_samples_avail(blip), blip_ref_samples_avail(ref));
+      break;
+    }
+
+    samples = blip_samples_avail(blip);
+    if (blip_read_samples(blip, out_new, samples) != blip_ref_read_samples(ref, out_ref, samples))
+    {
+      printf("frame %d: read samples count mismatch\n", i);
+      break;
+    }
+
+    if (memcmp(out_ref, out_new, samples * 2 * sizeof(short)))
+    {
+      int j = 0;
+      while (out_ref[j] == out_new[j]) j++;
+      printf("frame %d: sample %d (%s) is %d instead of %d\n", i, j / 2, (j & 1) ? "right" : "left", out_new[j], out_ref[j]);
+      break;
+    }
+  }
+
+  blip_ref_delete(ref);
+  blip_delete(blip);
+
+  return (i == frames);
+}
+
+int main(int argc, char **argv)
+{
+  int i, j, opt, failed = 0;
+  int frames = 500;
+
+  srand(1);
+
+  while ((opt = getopt(argc, argv, "s:n:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 's':
+        srand(strtoul(optarg, NULL, 0));
+        break;
+      case 'n':
+        frames = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-s seed] [-n frames]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  for (i = 0; i < (int)(sizeof(clock_rates) / sizeof(clock_rates[0])); i++)
+  {
+    for (j = 0; j < (int)(sizeof(sample_rates) / sizeof(sample_rates[0])); j++)
+    {
+      if (!test_rates(clock_rates[i], sample_rates[j], frames))
+      {
+        printf("clock rate %.0f Hz, sample rate %.0f Hz: output mismatch\n", clock_rates[i], sample_rates[j]);
+        failed++;
+      }
+    }
+  }
+
+  printf("%s\n", failed ? "FAILED" : "all outputs match");
+  return failed ? 1 : 0;
+}
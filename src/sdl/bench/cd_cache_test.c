@@ -0,0 +1,400 @@
+/*
+ *  cd_cache_test.c
+ *
+ *  CD image cache conformance test
+ *
+ *  Creates a CUE image (RAW data track, BINARY audio track with pregap, WAVE audio track
+ *  and subcode data file) in a temporary directory, creates its cache file with the cache
+ *  worker thread, mounts it and checks that all track sectors, subcode data and savestate
+ *  offsets match source image. Also checks cache file key, cache file creation abort and
+ *  least recently used cache files removal.
+ *
+ *  usage: cd_cache_test [-d directory]
+ *
+ *  -d directory : temporary directory (default /tmp)
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "shared.h"
+#include "md_ntsc.h"
+#include "sms_ntsc.h"
+
+/* cache files are created in test directory */
+static char cache_dir[256];
+#undef CD_CACHE_DIR
+#define CD_CACHE_DIR cache_dir
+
+/* cache internals are only accessible from CD drive code */
+#include "cdd.c"
+
+/* not used (required by core) */
+md_ntsc_t *md_ntsc;
+sms_ntsc_t *sms_ntsc;
+int log_error = 0;
+int debug_on = 0;
+
+int sdl_input_update(void)
+{
+  return 1;
+}
+
+/* test image */
+#define DATA_SECTORS 300
+#define AUDIO2_SECTORS 450
+#define AUDIO2_PREGAP 150
+#define AUDIO3_SECTORS 375
+
+static char dir[256];
+static char cue[256+16];
+
+static uint8 *ref_data;
+static uint8 *ref_audio[3];
+static track_t ref_tracks[3];
+
+static int failed;
+
+static void check(int ok, const char *msg)
+{
+  if (!ok)
+  {
+    printf("%s\n", msg);
+    failed++;
+  }
+}
+
+static uint8 noise(unsigned int seed, long pos)
+{
+  uint32 x = (uint32)pos * 2654435761u + seed;
+  x ^= x >> 13;
+  x *= 0x5bd1e995;
+  x ^= x >> 15;
+  return (uint8)x;
+}
+
+static void write_file(const char *name, const uint8 *head, int headSize, long size, unsigned int seed)
+{
+  char path[256+16];
+  FILE *f;
+  long i;
+
+  sprintf(path, "%s/%s", dir, name);
+  f = fopen(path, "wb");
+  if (head)
+  {
+    fwrite(head, headSize, 1, f);
+  }
+  for (i = 0; i < size; i++)
+  {
+    fputc(noise(seed, i), f);
+  }
+  fclose(f);
+}
+
+static void create_image(void)
+{
+  static const char *sheet =
+    "FILE \"game.bin\" BINARY\n"
+    "  TRACK 01 MODE1/2352\n"
+    "    INDEX 01 00:00:00\n"
+    "FILE \"track2.bin\" BINARY\n"
+    "  TRACK 02 AUDIO\n"
+    "    INDEX 00 00:00:00\n"
+    "    INDEX 01 00:02:00\n"
+    "FILE \"track3.wav\" WAVE\n"
+    "  TRACK 03 AUDIO\n"
+    "    INDEX 01 00:00:00\n";
+
+  uint8 wav[44];
+  uint32 size = AUDIO3_SECTORS * 2352;
+  FILE *f;
+
+  /* minimal WAVE header (16-bit stereo 44100 Hz PCM) */
+  memcpy(wav, "RIFF", 4);
+  wav[4] = (size + 36) & 0xff; wav[5] = ((size + 36) >> 8) & 0xff; wav[6] = ((size + 36) >> 16) & 0xff; wav[7] = (size + 36) >> 24;
+  memcpy(wav + 8, "WAVEfmt ", 8);
+  memcpy(wav + 16, "\x10\x00\x00\x00\x01\x00\x02\x00\x44\xac\x00\x00\x10\xb1\x02\x00\x04\x00\x10\x00", 20);
+  memcpy(wav + 36, "data", 4);
+  wav[40] = size & 0xff; wav[41] = (size >> 8) & 0xff; wav[42] = (size >> 16) & 0xff; wav[43] = size >> 24;
+
+  write_file("game.bin", NULL, 0, DATA_SECTORS * 2352, 1);
+  write_file("track2.bin", NULL, 0, (AUDIO2_PREGAP + AUDIO2_SECTORS) * 2352, 2);
+  write_file("track3.wav", wav, sizeof(wav), size, 3);
+  /* subcode data file is named after last track file */
+  write_file("track3.sub", NULL, 0, (DATA_SECTORS + AUDIO2_PREGAP + AUDIO2_SECTORS + AUDIO3_SECTORS) * 96, 4);
+
+  sprintf(cue, "%s/game.cue", dir);
+  f = fopen(cue, "w");
+  fputs(sheet, f);
+  fclose(f);
+}
+
+static int load_image(void)
+{
+  char header[0x210];
+  return (cdd_load(cue, header) == 1) && (cdd.toc.last == 3);
+}
+
+static uint8 *read_track(int index)
+{
+  int lba, length = (cdd.toc.tracks[index].end - cdd.toc.tracks[index].start);
+  int sectorSize = cdd.toc.tracks[index].type ? cdd.sectorSize : 2352;
+  uint8 *buf = (uint8 *)malloc(length * sectorSize);
+
+  /* track sectors */
+  for (lba = cdd.toc.tracks[index].start; lba < cdd.toc.tracks[index].end; lba++)
+  {
+    uint8 *dst = buf + (lba - cdd.toc.tracks[index].start) * sectorSize;
+    cdd_track_seek(index, (lba * sectorSize) - cdd.toc.tracks[index].offset);
+    if (cdd_track_read(index, dst, sectorSize) != sectorSize)
+    {
+      memset(dst, 0xff, sectorSize);
+    }
+  }
+
+  return buf;
+}
+
+static int count_files(const char *ext)
+{
+  DIR *d = opendir(cache_dir);
+  struct dirent *e;
+  int count = 0;
+
+  while (d && (e = readdir(d)))
+  {
+    if (strstr(e->d_name, ext)) count++;
+  }
+
+  if (d) closedir(d);
+  return count;
+}
+
+static int file_exists(const uint32 *key, const char *ext)
+{
+  char path[256+32];
+  struct stat st;
+  cdd_cache_path(path, key, ext);
+  return !stat(path, &st);
+}
+
+static int wait_cache(void)
+{
+  /* wait until cache file creation is finished */
+  if (!cdd_cache_job.started)
+  {
+    return 0;
+  }
+
+  pthread_join(cdd_cache_job.thread, NULL);
+  pthread_mutex_destroy(&cdd_cache_job.mutex);
+  cdd_cache_job.started = 0;
+  return 1;
+}
+
+static void test_cache(void)
+{
+  uint32 key[2], key2[2];
+  cdStream *fd;
+  long size;
+  int i, lba;
+
+  /* source image */
+  check(load_image(), "source image not loaded");
+  check(cdd_cache_key(key), "no cache key");
+  ref_data = read_track(0);
+  for (i = 1; i < 3; i++)
+  {
+    ref_audio[i] = read_track(i);
+  }
+  memcpy(ref_tracks, cdd.toc.tracks, sizeof(ref_tracks));
+
+  /* cache file creation aborted when image is unloaded */
+  cdd_cache_start(cue, key);
+  check(cdd_cache_job.started, "cache file creation not started");
+  cdd_unload();
+  check(!count_files(".tmp"), "temporary file left after cache file creation abort");
+
+  /* cache file creation */
+  check(load_image(), "source image not reloaded");
+  check(cdd_cache_key(key2) && !memcmp(key, key2, sizeof(key)), "cache key changed after reload");
+  cdd_cache_start(cue, key);
+  check(wait_cache(), "cache file creation not started");
+  check(!count_files(".tmp"), "temporary file left after cache file creation");
+  check(file_exists(key, "bin") && file_exists(key, "sub"), "cache files not created");
+  cdd_unload();
+
+  /* cache file mounting */
+  fd = cdd_cache_open(key, &size);
+  check(fd != NULL, "cache file not opened");
+  if (!fd)
+  {
+    return;
+  }
+  cdd_cache_mount(fd, key, (char *)cdc.ram);
+  check(cdd_cache_active && (cdd.toc.last == 3) && cdd.toc.sub, "cache file not mounted");
+
+  /* cache file should be used as a track file (memory-mapped when possible) */
+  check(cdd_file_find(fd) != NULL, "cache file stream not registered");
+#ifdef USE_CD_MMAP
+  for (i = 0; i < 3; i++)
+  {
+    check(cdd_track_map[i] && (cdd_track_map[i]->fd == fd), "cache file not memory-mapped");
+  }
+#endif
+
+  /* tracks data */
+  for (i = 0; i < 3; i++)
+  {
+    uint8 *data = read_track(i);
+    int length = (ref_tracks[i].end - ref_tracks[i].start) * (i ? 2352 : cdd.sectorSize);
+    check((cdd.toc.tracks[i].start == ref_tracks[i].start) && (cdd.toc.tracks[i].end == ref_tracks[i].end), "track position mismatch");
+    check(!memcmp(data, i ? ref_audio[i] : ref_data, length), "track data mismatch");
+    free(data);
+  }
+
+  /* subcode data */
+  {
+    uint8 ref[96], sub[96];
+    char path[256+16];
+    FILE *f;
+    sprintf(path, "%s/track3.sub", dir);
+    f = fopen(path, "rb");
+    for (lba = 0; f && (lba < cdd.toc.end); lba++)
+    {
+      if ((fread(ref, 96, 1, f) != 1) || (cdStreamRead(sub, 1, 96, cdd.toc.sub) != 96) || memcmp(ref, sub, 96))
+      {
+        check(0, "subcode data mismatch");
+        break;
+      }
+    }
+    if (f) fclose(f);
+  }
+
+  /* savestate offsets */
+  for (i = 1; i < 3; i++)
+  {
+    for (lba = ref_tracks[i].start; lba < ref_tracks[i].end; lba += 7)
+    {
+      int src = (lba * 2352) - ref_tracks[i].offset + (lba % 588) * 4;
+      int dst = (lba * 2352) - cdd.toc.tracks[i].offset + (lba % 588) * 4;
+      if ((cdd_cache_state_offset(i, dst) != src) || (cdd_cache_file_offset(i, src) != dst))
+      {
+        check(0, "savestate offset mismatch");
+        break;
+      }
+    }
+  }
+
+  cdd_unload();
+
+  /* cache key (source files size & data at start and end of each file) changes with first audio sample */
+  {
+    char path[256+16];
+    FILE *f;
+    sprintf(path, "%s/track3.wav", dir);
+    f = fopen(path, "r+b");
+    fseek(f, 44, SEEK_SET);
+    fputc(noise(3, 0) ^ 0xff, f);
+    fclose(f);
+  }
+  check(load_image(), "modified image not loaded");
+  check(cdd_cache_key(key2) && memcmp(key, key2, sizeof(key)), "cache key not changed with modified track file");
+  cdd_unload();
+}
+
+static void test_evict(void)
+{
+  static const uint32 keys[3][2] = {{1, 1}, {2, 2}, {3, 3}};
+  cdd_cache_index_t index;
+  int i;
+
+  /* cache files of known size (only size stored in index is used) */
+  for (i = 0; i < 3; i++)
+  {
+    char path[256+32];
+    FILE *f;
+    cdd_cache_path(path, keys[i], "bin");
+    f = fopen(path, "wb");
+    fclose(f);
+  }
+
+  /* least recently used cache file is removed when size limit is exceeded */
+  cdd_cache_index_update(keys[0], (CD_CACHE_MAX_SIZE / 4) * 1024);
+  cdd_cache_index_update(keys[1], (CD_CACHE_MAX_SIZE / 4) * 1024);
+  cdd_cache_index_update(keys[0], (CD_CACHE_MAX_SIZE / 4) * 1024);
+  check(file_exists(keys[0], "bin") && file_exists(keys[1], "bin"), "cache file removed below size limit");
+  cdd_cache_index_update(keys[2], (CD_CACHE_MAX_SIZE / 2) * 1024 + 1);
+  check(file_exists(keys[0], "bin") && !file_exists(keys[1], "bin") && file_exists(keys[2], "bin"), "least recently used cache file not removed");
+
+  /* cache file exceeding size limit is kept while used */
+  cdd_cache_index_update(keys[2], CD_CACHE_MAX_SIZE * 1024 + 1);
+  check(!file_exists(keys[0], "bin") && file_exists(keys[2], "bin"), "current cache file removed");
+
+  {
+    char path[256+16];
+    FILE *f;
+    sprintf(path, "%s/index.dat", cache_dir);
+    f = fopen(path, "rb");
+    check(f && (fread(&index, sizeof(index), 1, f) == 1) && (index.count == 1), "cache index not updated");
+    if (f) fclose(f);
+  }
+}
+
+static void cleanup(const char *path)
+{
+  DIR *d = opendir(path);
+  struct dirent *e;
+  char name[512+16];
+
+  while (d && (e = readdir(d)))
+  {
+    if (e->d_name[0] == '.') continue;
+    sprintf(name, "%s/%s", path, e->d_name);
+    if (strcmp(name, cache_dir)) remove(name);
+  }
+
+  if (d) closedir(d);
+  rmdir(path);
+}
+
+int main(int argc, char **argv)
+{
+  const char *tmp = "/tmp";
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'd':
+        tmp = optarg;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-d directory]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  sprintf(dir, "%.200s/cd_cache_test.%d", tmp, (int)getpid());
+  sprintf(cache_dir, "%.240s/cache", dir);
+  if (mkdir(dir, 0755) || mkdir(cache_dir, 0755))
+  {
+    fprintf(stderr, "can not create %s\n", cache_dir);
+    return 1;
+  }
+
+  create_image();
+  test_cache();
+  test_evict();
+
+  cleanup(cache_dir);
+  cleanup(dir);
+
+  printf("%s\n", failed ? "FAILED" : "all checks passed");
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,498 @@
+/*
+ *  main.c
+ *
+ *  Headless benchmark frontend
+ *
+ *  Runs the emulated system for a fixed number of frames, without any video,
+ *  audio or timer synchronization, and reports emulation speed, per-frame
+ *  latency percentiles and hashes of the rendered video & audio output.
+ *
+ *  usage: gen_bench [-f frames] [-w warmup] [-i script] [-r samplerate] [-p csvfile] [-x] [-n] [-y] [-s] [-q] gamename
+ *
+ *  Input script is a text file where each line is "frame pad1 [pad2]": pad states
+ *  (INPUT_xxx bitmasks, decimal or 0x-prefixed hexadecimal) are applied from the
+ *  specified frame until the next line. Lines starting with '#' are ignored.
+ *
+ *  When built with USE_PROFILER (make -f Makefile.bench PROFILER=1), per-subsystem
+ *  execution times are also reported and optionally written per frame to a CSV file.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shared.h"
+#include "sms_ntsc.h"
+#include "md_ntsc.h"
+
+#define SOUND_FREQUENCY 48000
+#define SOUND_SAMPLES_SIZE  2048
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME        0x100000001b3ULL
+
+int log_error   = 0;
+int debug_on    = 0;
+
+/* video */
+md_ntsc_t *md_ntsc;
+sms_ntsc_t *sms_ntsc;
+
+#if defined(USE_8BPP_RENDERING)
+static uint8 bitmap_data[720 * 576];
+#else
+/* large enough for XRGB8888 output */
+static uint32 bitmap_data[720 * 576];
+#endif
+
+/* sound */
+static int16 soundframe[SOUND_SAMPLES_SIZE * 2];
+
+/* scripted input */
+typedef struct
+{
+  uint32 frame;
+  uint16 pad[2];
+} t_input_event;
+
+static struct
+{
+  t_input_event *events;
+  int count;
+  int pos;
+} script;
+
+/* benchmark state */
+static struct
+{
+  uint32 frame;
+  uint64_t video_hash;
+  uint64_t audio_hash;
+  uint64_t audio_samples;
+} bench;
+
+static int load_script(const char *filename)
+{
+  char line[256];
+  int size = 0;
+  FILE *fp = fopen(filename, "r");
+
+  if (!fp)
+  {
+    return 0;
+  }
+
+  while (fgets(line, sizeof(line), fp))
+  {
+    char *ptr, *end;
+    t_input_event event;
+
+    /* skip comments & empty lines */
+    ptr = line;
+    while ((*ptr == ' ') || (*ptr == '\t')) ptr++;
+    if ((*ptr == '#') || (*ptr == '\n') || (*ptr == '\r') || (*ptr == 0))
+    {
+      continue;
+    }
+
+    event.frame = strtoul(ptr, &end, 0);
+    if (end == ptr)
+    {
+      continue;
+    }
+    event.pad[0] = strtoul(end, &end, 0);
+    event.pad[1] = strtoul(end, &end, 0);
+
+    /* grow events list */
+    if (script.count == size)
+    {
+      t_input_event *events;
+      size = size ? (size * 2) : 64;
+      events = realloc(script.events, size * sizeof(t_input_event));
+      if (!events)
+      {
+        fclose(fp);
+        return 0;
+      }
+      script.events = events;
+    }
+
+    script.events[script.count++] = event;
+  }
+
+  fclose(fp);
+  return 1;
+}
+
+int sdl_input_update(void)
+{
+  /* apply all scripted events up to current frame */
+  while ((script.pos < script.count) && (script.events[script.pos].frame <= bench.frame))
+  {
+    input.pad[0] = script.events[script.pos].pad[0];
+    input.pad[4] = script.events[script.pos].pad[1];
+    script.pos++;
+  }
+
+  return 1;
+}
+
+static uint64_t hash_update(uint64_t hash, const uint8 *data, int size)
+{
+  while (size--)
+  {
+    hash ^= *data++;
+    hash *= FNV_PRIME;
+  }
+
+  return hash;
+}
+
+static void hash_frame(int samples)
+{
+  int y;
+  int width = (bitmap.viewport.w + 2 * bitmap.viewport.x) * (bitmap.pitch / bitmap.width);
+  int height = bitmap.viewport.h + 2 * bitmap.viewport.y;
+
+  /* NTSC filtered lines are wider */
+  if (config.ntsc)
+  {
+    width = bitmap.pitch;
+  }
+
+  /* rendered video area */
+  for (y = 0; y < height; y++)
+  {
+    bench.video_hash = hash_update(bench.video_hash, bitmap.data + (y * bitmap.pitch), width);
+  }
+
+  /* output audio samples (stereo) */
+  bench.audio_hash = hash_update(bench.audio_hash, (uint8 *)soundframe, samples * 2 * sizeof(int16));
+  bench.audio_samples += samples;
+}
+
+static double get_time_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec * 1000000.0) + (ts.tv_nsec / 1000.0);
+}
+
+static int compare_times(const void *a, const void *b)
+{
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+static double percentile(const double *sorted, int count, int p)
+{
+  int index = ((count - 1) * p) / 100;
+  return sorted[index];
+}
+
+static int run_frame(int do_skip)
+{
+  if (system_hw == SYSTEM_MCD)
+  {
+    system_frame_scd(do_skip);
+  }
+  else if ((system_hw & SYSTEM_PBC) == SYSTEM_MD)
+  {
+    system_frame_gen(do_skip);
+  }
+  else
+  {
+    system_frame_sms(do_skip);
+  }
+
+  return audio_update(soundframe);
+}
+
+static void usage(const char *name)
+{
+  printf("Genesis Plus GX headless benchmark\n");
+  printf("usage: %s [options] gamename\n", name);
+  printf("  -f frames      number of measured frames (default 3600)\n");
+  printf("  -w frames      number of warmup frames, not measured (default 0)\n");
+  printf("  -i script      scripted input file (\"frame pad1 [pad2]\" per line)\n");
+  printf("  -r samplerate  audio output rate (default %d)\n", SOUND_FREQUENCY);
+#ifdef USE_PROFILER
+  printf("  -p csvfile     write per-frame subsystem profile to CSV file\n");
+#endif
+#if defined(USE_15BPP_RENDERING) || defined(USE_16BPP_RENDERING)
+  printf("  -x             XRGB8888 video output\n");
+  printf("  -n             NTSC composite video filter\n");
+#endif
+#ifdef HAVE_YM3438_CORE
+  printf("  -y             Nuked YM3438 FM core\n");
+#endif
+  printf("  -s             skip video rendering\n");
+  printf("  -v             no video output (sprite status flags still emulated)\n");
+  printf("  -q             only print hashes\n");
+}
+
+int main (int argc, char **argv)
+{
+  int i, opt;
+  int frames = 3600;
+  int warmup = 0;
+  int samplerate = SOUND_FREQUENCY;
+  int do_skip = 0;
+  int quiet = 0;
+  int bpp = 0;
+  int ntsc = 0;
+  int ym3438 = 0;
+  char *script_name = NULL;
+  double *times, total, start;
+#ifdef USE_PROFILER
+  FILE *csv = NULL;
+#endif
+
+  while ((opt = getopt(argc, argv, "f:w:i:r:p:xnysvqh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'f':
+        frames = atoi(optarg);
+        break;
+      case 'w':
+        warmup = atoi(optarg);
+        break;
+      case 'i':
+        script_name = optarg;
+        break;
+      case 'r':
+        samplerate = atoi(optarg);
+        break;
+#ifdef USE_PROFILER
+      case 'p':
+        csv = fopen(optarg, "w");
+        if (!csv)
+        {
+          fprintf(stderr, "Can't open profile file `%s'.\n", optarg);
+          return 1;
+        }
+        profiler_write_csv_header(csv);
+        break;
+#endif
+#if defined(USE_15BPP_RENDERING) || defined(USE_16BPP_RENDERING)
+      case 'x':
+        bpp = 32;
+        break;
+      case 'n':
+        ntsc = 1;
+        break;
+#endif
+#ifdef HAVE_YM3438_CORE
+      case 'y':
+        ym3438 = 1;
+        break;
+#endif
+      case 's':
+        do_skip = 1;
+        break;
+      case 'v':
+        video_hard_disable = 1;
+        break;
+      case 'q':
+        quiet = 1;
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+
+  /* maximal number of samples per frame must fit in sound buffer */
+  if ((optind >= argc) || (frames <= 0) || (warmup < 0) || (samplerate < 8000) || (samplerate > 96000))
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (script_name && !load_script(script_name))
+  {
+    fprintf(stderr, "Error loading input script `%s'.\n", script_name);
+    return 1;
+  }
+
+  times = malloc(frames * sizeof(double));
+  if (!times)
+  {
+    fprintf(stderr, "Can't allocate frame times buffer\n");
+    return 1;
+  }
+
+  /* set default config */
+  error_init();
+  set_config_defaults();
+  config.ym3438 = ym3438;
+
+  /* deterministic power-on state */
+  srand(0);
+
+  /* NTSC filter (not supported with XRGB8888 output) */
+  if (ntsc && !bpp)
+  {
+    sms_ntsc = calloc(1, sizeof(sms_ntsc_t));
+    md_ntsc  = calloc(1, sizeof(md_ntsc_t));
+    if (!sms_ntsc || !md_ntsc)
+    {
+      fprintf(stderr, "Can't allocate NTSC filter\n");
+      return 1;
+    }
+    sms_ntsc_init(sms_ntsc, &sms_ntsc_composite);
+    md_ntsc_init(md_ntsc, &md_ntsc_composite);
+    config.ntsc = 1;
+  }
+
+  /* mark all BIOS as unloaded */
+  system_bios = 0;
+  memset(boot_rom, 0xFF, 0x800);
+
+  /* initialize Genesis virtual system */
+  memset(&bitmap, 0, sizeof(t_bitmap));
+  bitmap.width        = 720;
+  bitmap.height       = 576;
+  bitmap.bpp          = bpp;
+#if defined(USE_8BPP_RENDERING)
+  bitmap.pitch        = bitmap.width;
+#elif defined(USE_32BPP_RENDERING)
+  bitmap.pitch        = bitmap.width * 4;
+#else
+  bitmap.pitch        = bitmap.width * (bpp ? 4 : 2);
+#endif
+  bitmap.data         = (uint8 *)bitmap_data;
+  bitmap.viewport.changed = 3;
+
+  /* Load game file */
+  if (!load_rom(argv[optind]))
+  {
+    fprintf(stderr, "Error loading file `%s'.\n", argv[optind]);
+    return 1;
+  }
+
+  /* initialize system hardware */
+  audio_init(samplerate, 0);
+  system_init();
+
+  /* reset system hardware */
+  system_reset();
+
+  bench.video_hash = FNV_OFFSET_BASIS;
+  bench.audio_hash = FNV_OFFSET_BASIS;
+
+  /* warmup frames (hashed but not measured) */
+  for (bench.frame = 0; bench.frame < warmup; bench.frame++)
+  {
+    hash_frame(run_frame(do_skip));
+  }
+
+#ifdef USE_PROFILER
+  /* only profile measured frames */
+  profiler_reset();
+#endif
+
+  /* measured frames */
+  total = 0;
+  for (i = 0; i < frames; i++, bench.frame++)
+  {
+    int samples;
+
+    start = get_time_us();
+    samples = run_frame(do_skip);
+    times[i] = get_time_us() - start;
+    total += times[i];
+
+#ifdef USE_PROFILER
+    profiler_frame();
+    if (csv)
+    {
+      profiler_write_csv(csv, profiler_get_frame());
+    }
+#endif
+
+    hash_frame(samples);
+  }
+
+  if (!quiet)
+  {
+    qsort(times, frames, sizeof(double), compare_times);
+
+    printf("game        : %s\n", (rominfo.international[0] != 0x20) ? rominfo.international : rominfo.domestic);
+    printf("system      : 0x%02x (%s)\n", system_hw, vdp_pal ? "PAL" : "NTSC");
+    printf("frames      : %d (+%d warmup)\n", frames, warmup);
+    printf("total time  : %.3f ms\n", total / 1000.0);
+    printf("speed       : %.2f fps (%.2fx realtime)\n", (frames * 1000000.0) / total,
+           (frames * 1000000.0) / total / (vdp_pal ? 50.0 : 60.0));
+    printf("frame time  : min %.1f / p50 %.1f / p90 %.1f / p99 %.1f / max %.1f us\n",
+           times[0], percentile(times, frames, 50), percentile(times, frames, 90),
+           percentile(times, frames, 99), times[frames - 1]);
+    printf("audio       : %llu samples\n", (unsigned long long)bench.audio_samples);
+
+#ifdef USE_PROFILER
+    {
+      const t_profile *prof = profiler_get_total();
+      unsigned long long sum = 0;
+
+      for (i = 0; i < PROF_MAX; i++)
+      {
+        sum += prof->time[i];
+      }
+
+      printf("profile     : subsystem    us/frame   calls/frame   share\n");
+      for (i = 0; i < PROF_MAX; i++)
+      {
+        printf("              %-9s %10.1f %13.1f %6.1f%%\n", profiler_get_name(i),
+               (prof->time[i] / 1000.0) / prof->frames, (double)prof->calls[i] / prof->frames,
+               sum ? ((prof->time[i] * 100.0) / sum) : 0.0);
+      }
+    }
+#endif
+  }
+
+  printf("video hash  : %016llx\n", (unsigned long long)bench.video_hash);
+  printf("audio hash  : %016llx\n", (unsigned long long)bench.audio_hash);
+
+#if defined(ENABLE_M68K_SKIP_IDLE_LOOPS) && defined(ENABLE_M68K_CHECK_IDLE_LOOPS)
+  printf("idle loops  : %u mismatch(es)\n", m68k_idle_loop_errors);
+#endif
+
+#ifdef USE_PROFILER
+  if (csv)
+  {
+    fclose(csv);
+  }
+#endif
+
+  free(times);
+  free(script.events);
+
+#ifdef USE_RENDER_THREAD
+  render_shutdown();
+#endif
+
+#ifdef USE_FM_THREAD
+  sound_shutdown();
+#endif
+
+#ifdef USE_CD_CACHE
+  /* stop CD image cache file creation */
+  cdd_unload();
+#endif
+
+  free(sms_ntsc);
+  free(md_ntsc);
+
+  audio_shutdown();
+  error_shutdown();
+
+#if defined(ENABLE_M68K_SKIP_IDLE_LOOPS) && defined(ENABLE_M68K_CHECK_IDLE_LOOPS)
+  return m68k_idle_loop_errors ? 1 : 0;
+#else
+  return 0;
+#endif
+}
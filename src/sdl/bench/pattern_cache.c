@@ -0,0 +1,158 @@
+/*
+ *  pattern_cache.c
+ *
+ *  Mode 5 pattern cache benchmark
+ *
+ *  Runs update_bg_pattern_cache_m5() and the original pixel by pixel implementation
+ *  on the same random VRAM contents and modified pattern lines, checks that both
+ *  produce the same pattern cache and reports their average execution time.
+ *
+ *  usage: pattern_cache [-n passes] [-p patterns] [-d dirty]
+ *
+ *  -n passes   : number of pattern cache updates with each implementation (default 2000)
+ *  -p patterns : number of modified patterns per update (1-2048, default 2048)
+ *  -d dirty    : percentage of modified lines in each modified pattern (1-100, default 100)
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#define HAVE_SCALAR_PATTERN_CACHE
+
+#include <time.h>
+#include <unistd.h>
+
+/* pattern cache is only accessible from renderer code */
+#include "vdp_render.c"
+
+/* not used (required by core) */
+md_ntsc_t *md_ntsc;
+sms_ntsc_t *sms_ntsc;
+int log_error = 0;
+int debug_on = 0;
+
+int sdl_input_update(void)
+{
+  return 1;
+}
+
+static uint8 cache_start[sizeof(bg_pattern_cache)];
+static uint8 cache_ref[sizeof(bg_pattern_cache)];
+static uint8 dirty_list[0x800];
+
+static double get_time_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec * 1000000.0) + (ts.tv_nsec / 1000.0);
+}
+
+static void set_dirty(int patterns)
+{
+  int i;
+
+  for (i = 0; i < patterns; i++)
+  {
+    bg_name_dirty[bg_name_list[i]] = dirty_list[i];
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int i, j, opt;
+  int passes = 2000;
+  int patterns = 0x800;
+  int dirty = 100;
+  double start, time_ref = 0, time_new = 0;
+
+  while ((opt = getopt(argc, argv, "n:p:d:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        passes = atoi(optarg);
+        break;
+      case 'p':
+        patterns = atoi(optarg);
+        break;
+      case 'd':
+        dirty = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n passes] [-p patterns] [-d dirty]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if ((passes <= 0) || (patterns <= 0) || (patterns > 0x800) || (dirty <= 0) || (dirty > 100))
+  {
+    fprintf(stderr, "invalid parameters\n");
+    return 1;
+  }
+
+  srand(1);
+
+  /* random pattern order (all pattern names are different) */
+  for (i = 0; i < 0x800; i++)
+  {
+    bg_name_list[i] = i;
+  }
+  for (i = 0x7ff; i > 0; i--)
+  {
+    uint16 name = bg_name_list[i];
+    j = rand() % (i + 1);
+    bg_name_list[i] = bg_name_list[j];
+    bg_name_list[j] = name;
+  }
+
+  for (i = 0; i < passes; i++)
+  {
+    /* random VRAM contents */
+    for (j = 0; j < 0x10000; j++)
+    {
+      vram[j] = rand();
+    }
+
+    /* random modified lines */
+    for (j = 0; j < patterns; j++)
+    {
+      int y;
+      dirty_list[j] = 0;
+      for (y = 0; y < 8; y++)
+      {
+        if ((rand() % 100) < dirty)
+        {
+          dirty_list[j] |= (1 << y);
+        }
+      }
+    }
+
+    memcpy(cache_start, bg_pattern_cache, sizeof(bg_pattern_cache));
+
+    /* original implementation */
+    set_dirty(patterns);
+    start = get_time_us();
+    update_bg_pattern_cache_m5_scalar(patterns);
+    time_ref += get_time_us() - start;
+    memcpy(cache_ref, bg_pattern_cache, sizeof(bg_pattern_cache));
+
+    /* current implementation, from the same initial pattern cache */
+    memcpy(bg_pattern_cache, cache_start, sizeof(bg_pattern_cache));
+    set_dirty(patterns);
+    start = get_time_us();
+    update_bg_pattern_cache_m5(patterns);
+    time_new += get_time_us() - start;
+
+    if (memcmp(cache_ref, bg_pattern_cache, sizeof(bg_pattern_cache)))
+    {
+      printf("pattern cache mismatch at pass %d\n", i);
+      return 1;
+    }
+  }
+
+  printf("passes      : %d (%d patterns, %d%% lines modified)\n", passes, patterns, dirty);
+  printf("scalar      : %.3f us/update\n", time_ref / passes);
+  printf("current     : %.3f us/update (%.2fx)\n", time_new / passes, time_ref / time_new);
+  printf("cache       : identical\n");
+
+  return 0;
+}
@@ -0,0 +1,31 @@
+/*
+ *  ym2612_ref.c
+ *
+ *  Reference YM2612 implementation (silent channels fast paths disabled) for YM2612 conformance test
+ *
+ *  All public functions are renamed with a YM2612Ref prefix so that it can be linked
+ *  together with default YM2612 implementation.
+ */
+
+#define YM2612_NO_FAST_PATH
+
+#define YM2612Init          YM2612RefInit
+#define YM2612Config        YM2612RefConfig
+#define YM2612ResetChip     YM2612RefResetChip
+#define YM2612Update        YM2612RefUpdate
+#define YM2612Write         YM2612RefWrite
+#define YM2612Read          YM2612RefRead
+#define YM2612LoadContext   YM2612RefLoadContext
+#define YM2612SaveContext   YM2612RefSaveContext
+#define YM2612TimersSync    YM2612RefTimersSync
+#define YM2612TimersUpdate  YM2612RefTimersUpdate
+#define YM2612TimersWrite   YM2612RefTimersWrite
+#define YM2612TimersRead    YM2612RefTimersRead
+
+#include "ym2612.c"
+
+/* reference chip state */
+const void *YM2612RefChip(void)
+{
+  return &ym2612;
+}
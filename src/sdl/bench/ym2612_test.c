@@ -0,0 +1,249 @@
+/*
+ *  ym2612_test.c
+ *
+ *  YM2612 silent channels fast paths conformance test
+ *
+ *  Runs default YM2612 implementation and reference implementation (ym2612_ref.c,
+ *  compiled with YM2612_NO_FAST_PATH) on the same random register write traces,
+ *  with channels playing notes, releasing, muted or keyed off for long periods,
+ *  and checks that output samples, status and complete chip state stay identical.
+ *
+ *  usage: ym2612_test [-s seed] [-n traces] [-w writes]
+ *
+ *  -s seed   : first random trace seed (default 1)
+ *  -n traces : number of random traces per chip type (default 4)
+ *  -w writes : number of register writes per trace (default 5000)
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* chip state is only accessible from chip code */
+#include "ym2612.c"
+
+/* reference implementation (ym2612_ref.c) */
+void YM2612RefInit(void);
+void YM2612RefConfig(int type);
+void YM2612RefResetChip(void);
+void YM2612RefUpdate(int *buffer, int length);
+void YM2612RefWrite(unsigned int a, unsigned int v);
+unsigned int YM2612RefRead(void);
+const void *YM2612RefChip(void);
+
+#define MAX_RUN 3000
+
+static int buf_ref[MAX_RUN * 2];
+static int buf_new[MAX_RUN * 2];
+
+static YM2612 chip_ref;
+static YM2612 chip_new;
+
+static unsigned int seed;
+
+static unsigned int rnd(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 16) & 0x7fff;
+}
+
+/* copy chip state, with pointers replaced by indexes or cleared (connections only depend on algorithm) */
+static void chip_copy(YM2612 *dst, const YM2612 *src)
+{
+  int c, s;
+
+  memcpy(dst, src, sizeof(YM2612));
+
+  for (c = 0; c < 6; c++)
+  {
+    for (s = 0; s < 4; s++)
+    {
+      dst->CH[c].SLOT[s].DT = (INT32 *)(size_t)(src->CH[c].SLOT[s].DT - src->OPN.ST.dt_tab[0]);
+    }
+    dst->CH[c].connect1 = dst->CH[c].connect2 = dst->CH[c].connect3 = dst->CH[c].connect4 = NULL;
+    dst->CH[c].mem_connect = NULL;
+  }
+}
+
+static int run(int length)
+{
+  memset(buf_ref, 0, length * 2 * sizeof(int));
+  memset(buf_new, 0, length * 2 * sizeof(int));
+
+  YM2612RefUpdate(buf_ref, length);
+  YM2612Update(buf_new, length);
+
+  if (memcmp(buf_ref, buf_new, length * 2 * sizeof(int)) || (YM2612RefRead() != YM2612Read()))
+  {
+    return 1;
+  }
+
+  chip_copy(&chip_ref, (const YM2612 *)YM2612RefChip());
+  chip_copy(&chip_new, &ym2612);
+  return memcmp(&chip_ref, &chip_new, sizeof(YM2612));
+}
+
+static int reg_write(int port, int reg, int data)
+{
+  YM2612RefWrite(port * 2, reg);
+  YM2612Write(port * 2, reg);
+  YM2612RefWrite(port * 2 + 1, data);
+  YM2612Write(port * 2 + 1, data);
+  return run(rnd() % 40);
+}
+
+static int fm_note(int ch)
+{
+  int port = ch / 3;
+  int op, reg;
+
+  /* operators setup (mostly audible, fast release) */
+  for (op = 0; op < 4; op++)
+  {
+    reg = op * 4 + (ch % 3);
+    if (reg_write(port, 0x30 + reg, rnd() & 0x7f)) return 1;
+    if (reg_write(port, 0x40 + reg, rnd() & ((rnd() % 4) ? 0x1f : 0x7f))) return 1;
+    if (reg_write(port, 0x50 + reg, (rnd() & 0xc0) | 0x10 | (rnd() & 0x0f))) return 1;
+    if (reg_write(port, 0x60 + reg, rnd() & 0x9f)) return 1;
+    if (reg_write(port, 0x70 + reg, rnd() & 0x1f)) return 1;
+    if (reg_write(port, 0x80 + reg, (rnd() & 0xf0) | ((rnd() % 4) ? 0x0f : (rnd() & 0x0f)))) return 1;
+    if (reg_write(port, 0x90 + reg, (rnd() % 8) ? 0 : (0x08 | (rnd() & 0x07)))) return 1;
+  }
+
+  /* channel setup (mostly both outputs enabled, LFO phase modulation rarely enabled) */
+  if (reg_write(port, 0xa4 + (ch % 3), rnd() & 0x3f)) return 1;
+  if (reg_write(port, 0xa0 + (ch % 3), rnd() & 0xff)) return 1;
+  if (reg_write(port, 0xb0 + (ch % 3), rnd() & 0x3f)) return 1;
+  if (reg_write(port, 0xb4 + (ch % 3), ((rnd() % 4) ? 0xc0 : (rnd() & 0xc0)) | (rnd() & 0x30) | ((rnd() % 4) ? 0 : (rnd() & 0x07)))) return 1;
+
+  /* key on, hold, key off */
+  if (reg_write(0, 0x28, 0xf0 | (port << 2) | (ch % 3))) return 1;
+  if (run(1 + rnd() % MAX_RUN)) return 1;
+  return reg_write(0, 0x28, (port << 2) | (ch % 3));
+}
+
+static int test_trace(unsigned int trace, int type, int writes)
+{
+  int i;
+
+  seed = trace;
+  YM2612RefInit();
+  YM2612RefConfig(type);
+  YM2612RefResetChip();
+  YM2612Init();
+  YM2612Config(type);
+  YM2612ResetChip();
+
+  for (i = 0; i < writes; i++)
+  {
+    int c = rnd() % 16;
+    int port = rnd() & 1;
+    int reg;
+    int data = rnd() & 0xff;
+
+    if (c < 3)
+    {
+      /* complete note on a random channel */
+      if (fm_note(rnd() % 6))
+      {
+        return i;
+      }
+      continue;
+    }
+    else if (c < 5)
+    {
+      /* key on/off (mostly all operators off) */
+      port = 0;
+      reg = 0x28;
+      data = ((rnd() % 8) ? 0 : (rnd() & 0xf0)) | (rnd() % 8);
+    }
+    else if (c == 5)
+    {
+      /* LFO, timers, CSM & 3-slot modes (LFO and CSM mode are rarely enabled) */
+      port = 0;
+      reg = 0x22 + rnd() % 6;
+      if ((reg == 0x22) && (rnd() % 4)) data &= 0x07;
+      if ((reg == 0x27) && (rnd() % 4)) data &= 0x7f;
+    }
+    else if (c == 6)
+    {
+      /* DAC mode & data (DAC mode is rarely enabled) */
+      port = 0;
+      reg = 0x2a + (rnd() & 1);
+      if ((reg == 0x2b) && (rnd() % 4)) data = 0;
+    }
+    else if (c < 9)
+    {
+      /* long run, channels are likely to be silent or off after release */
+      if (run(1 + rnd() % MAX_RUN))
+      {
+        return i;
+      }
+      continue;
+    }
+    else if (c == 9)
+    {
+      /* total level (mute or unmute an operator) */
+      reg = 0x40 + rnd() % 16;
+      data = (rnd() & 1) ? 0x7f : (rnd() & 0x1f);
+    }
+    else
+    {
+      /* channel & operator registers (fast release rate) */
+      reg = 0x30 + rnd() % 0x88;
+      if ((reg & 0xf0) == 0x80) data |= 0x0f;
+    }
+
+    if (reg_write(port, reg, data))
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+int main(int argc, char **argv)
+{
+  int opt, type, n, failed = 0;
+  unsigned int first = 1;
+  int traces = 4;
+  int writes = 5000;
+
+  while ((opt = getopt(argc, argv, "s:n:w:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 's':
+        first = strtoul(optarg, NULL, 0);
+        break;
+      case 'n':
+        traces = atoi(optarg);
+        break;
+      case 'w':
+        writes = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-s seed] [-n traces] [-w writes]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  for (type = YM2612_DISCRETE; type <= YM2612_ENHANCED; type++)
+  {
+    for (n = 0; n < traces; n++)
+    {
+      int last = test_trace(first + n, type, writes);
+      if (last >= 0)
+      {
+        printf("chip type %d, trace %u: mismatch after %d register writes\n", type, first + n, last);
+        failed++;
+      }
+    }
+  }
+
+  printf("%s\n", failed ? "FAILED" : "all traces match");
+  return failed ? 1 : 0;
+}
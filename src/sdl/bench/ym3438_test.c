@@ -0,0 +1,341 @@
+/*
+ *  ym3438_test.c
+ *
+ *  Nuked YM3438 batched clocking conformance test
+ *
+ *  Runs two chips on the same random register write traces: one is clocked one cycle
+ *  at a time with OPN2_Clock() (reference implementation), the other one is clocked
+ *  in runs ending at the 24-cycle output accumulator boundary with OPN2_Clocks(), as
+ *  done by YM3438_Update(), which allows skipping FM stages while chip is quiet.
+ *  Output samples and complete chip state must stay identical.
+ *
+ *  OPN2_FMGenerate() silent operator shortcut is also checked against the generic
+ *  operator output calculation, for all envelope levels and phases.
+ *
+ *  usage: ym3438_test [-s seed] [-n traces] [-w writes]
+ *
+ *  -s seed   : first random trace seed (default 1)
+ *  -n traces : number of random traces per chip type (default 4)
+ *  -w writes : number of register writes per trace (default 5000)
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* operator output tables are only accessible from chip code */
+#include "ym3438.c"
+
+#define MAX_RUN 3000
+
+typedef struct
+{
+  ym3438_t chip;
+  Bit16s accm[24][2];
+  int sample[2];
+  int cycles;
+} t_fm;
+
+static t_fm fm_ref;
+static t_fm fm_new;
+
+static int buf_ref[MAX_RUN * 2];
+static int buf_new[MAX_RUN * 2];
+
+static unsigned int seed;
+
+static unsigned int rnd(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 16) & 0x7fff;
+}
+
+static void fm_sum(t_fm *fm)
+{
+  int j;
+  fm->sample[0] = fm->sample[1] = 0;
+  for (j = 0; j < 24; j++)
+  {
+    fm->sample[0] += fm->accm[j][0];
+    fm->sample[1] += fm->accm[j][1];
+  }
+}
+
+/* original YM3438_Update() */
+static void update_ref(t_fm *fm, int *buffer, int length)
+{
+  int i;
+  for (i = 0; i < length; i++)
+  {
+    OPN2_Clock(&fm->chip, fm->accm[fm->cycles]);
+    fm->cycles = (fm->cycles + 1) % 24;
+    if (fm->cycles == 0)
+    {
+      fm_sum(fm);
+    }
+    *buffer++ = fm->sample[0] * 11;
+    *buffer++ = fm->sample[1] * 11;
+  }
+}
+
+/* batched YM3438_Update() */
+static void update_new(t_fm *fm, int *buffer, int length)
+{
+  int i, n;
+  while (length > 0)
+  {
+    n = 24 - fm->cycles;
+    if (n > length)
+    {
+      n = length;
+    }
+    OPN2_Clocks(&fm->chip, &fm->accm[fm->cycles], n);
+    fm->cycles = (fm->cycles + n) % 24;
+    length -= n;
+    for (i = 1; i < n; i++)
+    {
+      *buffer++ = fm->sample[0] * 11;
+      *buffer++ = fm->sample[1] * 11;
+    }
+    if (fm->cycles == 0)
+    {
+      fm_sum(fm);
+    }
+    *buffer++ = fm->sample[0] * 11;
+    *buffer++ = fm->sample[1] * 11;
+  }
+}
+
+static int run(int length)
+{
+  update_ref(&fm_ref, buf_ref, length);
+  update_new(&fm_new, buf_new, length);
+  return memcmp(buf_ref, buf_new, length * 2 * sizeof(int)) || memcmp(&fm_ref, &fm_new, sizeof(t_fm));
+}
+
+static int fm_write(int port, int reg, int data)
+{
+  OPN2_Write(&fm_ref.chip, port * 2, reg);
+  OPN2_Write(&fm_new.chip, port * 2, reg);
+  if (run(rnd() % 40))
+  {
+    return 1;
+  }
+  OPN2_Write(&fm_ref.chip, port * 2 + 1, data);
+  OPN2_Write(&fm_new.chip, port * 2 + 1, data);
+  return run(rnd() % 60);
+}
+
+static int fm_note(int ch)
+{
+  int port = ch / 3;
+  int op, reg;
+
+  /* operators setup (mostly audible, fast release) */
+  for (op = 0; op < 4; op++)
+  {
+    reg = op * 4 + (ch % 3);
+    if (fm_write(port, 0x30 + reg, rnd() & 0x7f)) return 1;
+    if (fm_write(port, 0x40 + reg, rnd() & ((rnd() % 4) ? 0x1f : 0x7f))) return 1;
+    if (fm_write(port, 0x50 + reg, (rnd() & 0xc0) | 0x10 | (rnd() & 0x0f))) return 1;
+    if (fm_write(port, 0x60 + reg, rnd() & 0x9f)) return 1;
+    if (fm_write(port, 0x70 + reg, rnd() & 0x1f)) return 1;
+    if (fm_write(port, 0x80 + reg, (rnd() & 0xf0) | ((rnd() % 4) ? 0x0f : (rnd() & 0x0f)))) return 1;
+    if (fm_write(port, 0x90 + reg, (rnd() % 8) ? 0 : (0x08 | (rnd() & 0x07)))) return 1;
+  }
+
+  /* channel setup (mostly both outputs enabled) */
+  if (fm_write(port, 0xa4 + (ch % 3), rnd() & 0x3f)) return 1;
+  if (fm_write(port, 0xa0 + (ch % 3), rnd() & 0xff)) return 1;
+  if (fm_write(port, 0xb0 + (ch % 3), rnd() & 0x3f)) return 1;
+  if (fm_write(port, 0xb4 + (ch % 3), ((rnd() % 4) ? 0xc0 : (rnd() & 0xc0)) | (rnd() & 0x37))) return 1;
+
+  /* key on, hold, key off */
+  if (fm_write(0, 0x28, 0xf0 | (port << 2) | (ch % 3))) return 1;
+  if (run(1 + rnd() % MAX_RUN)) return 1;
+  return fm_write(0, 0x28, (port << 2) | (ch % 3));
+}
+
+static int test_trace(unsigned int trace, int type, int writes)
+{
+  int i;
+
+  seed = trace;
+  memset(&fm_ref, 0, sizeof(t_fm));
+  OPN2_SetChipType(type);
+  OPN2_Reset(&fm_ref.chip);
+  fm_new = fm_ref;
+
+  for (i = 0; i < writes; i++)
+  {
+    int c = rnd() % 16;
+    int port = rnd() & 1;
+    int reg;
+    int data = rnd() & 0xff;
+
+    if (c < 2)
+    {
+      /* complete note on a random channel */
+      if (fm_note(rnd() % 6))
+      {
+        return i;
+      }
+      continue;
+    }
+    else if (c < 4)
+    {
+      /* key on/off (mostly all operators off) */
+      port = 0;
+      reg = 0x28;
+      data = ((rnd() % 8) ? 0 : (rnd() & 0xf0)) | (rnd() % 8);
+    }
+    else if (c == 4)
+    {
+      /* LFO, test registers, timers, CSM & DAC modes (test registers are rarely set) */
+      port = 0;
+      reg = 0x20 + rnd() % 16;
+      if (((reg == 0x21) || (reg == 0x2c)) && (rnd() % 8)) reg = 0x22;
+      if ((reg == 0x27) && (rnd() % 4)) data &= 0x3f;
+      if ((reg == 0x2b) && (rnd() % 4)) data = 0;
+    }
+    else if (c == 5)
+    {
+      /* DAC data */
+      port = 0;
+      reg = 0x2a;
+    }
+    else if (c < 8)
+    {
+      /* long run, chip is likely to be quiet after release */
+      if (run(1 + rnd() % MAX_RUN))
+      {
+        return i;
+      }
+      continue;
+    }
+    else if (c == 8)
+    {
+      /* status read */
+      if (OPN2_Read(&fm_ref.chip, 0) != OPN2_Read(&fm_new.chip, 0))
+      {
+        return i;
+      }
+      continue;
+    }
+    else
+    {
+      /* channel & operator registers (fast release rate) */
+      reg = 0x30 + rnd() % 0x88;
+      if ((reg & 0xf0) == 0x80) data |= 0x0f;
+    }
+
+    if (fm_write(port, reg, data))
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static int test_silent_operator(void)
+{
+  static ym3438_t chip;
+  Bit32u test, eg_out, phase;
+
+  /* cycle 5 generates slot 0 output */
+  memset(&chip, 0, sizeof(chip));
+  chip.cycles = 5;
+
+  for (test = 0; test < 2; test++)
+  {
+    chip.mode_test_21[4] = test;
+    for (eg_out = 0; eg_out < 0x400; eg_out++)
+    {
+      chip.eg_out[0] = eg_out;
+      for (phase = 0; phase < 0x400; phase++)
+      {
+        /* generic operator output calculation */
+        Bit16u quarter = (phase & 0x100) ? ((phase ^ 0xff) & 0xff) : (phase & 0xff);
+        Bit16u level = logsinrom[quarter] + (eg_out << 2);
+        Bit16s output;
+        if (level > 0x1fff)
+        {
+          level = 0x1fff;
+        }
+        output = ((exprom[(level & 0xff) ^ 0xff] | 0x400) << 2) >> (level >> 8);
+        if (phase & 0x200)
+        {
+          output = ((~output) ^ (test << 13)) + 1;
+        }
+        else
+        {
+          output = output ^ (test << 13);
+        }
+        output <<= 2;
+        output >>= 2;
+
+        chip.fm_mod[0] = phase;
+        chip.fm_out[0] = 0x1234;
+        OPN2_FMGenerate(&chip);
+        if (chip.fm_out[0] != output)
+        {
+          printf("operator output %d instead of %d (envelope %03x, phase %03x, test %d)\n", chip.fm_out[0], output, eg_out, phase, test);
+          return 0;
+        }
+      }
+    }
+  }
+
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  int opt, type, n, failed = 0;
+  unsigned int first = 1;
+  int traces = 4;
+  int writes = 5000;
+
+  while ((opt = getopt(argc, argv, "s:n:w:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 's':
+        first = strtoul(optarg, NULL, 0);
+        break;
+      case 'n':
+        traces = atoi(optarg);
+        break;
+      case 'w':
+        writes = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-s seed] [-n traces] [-w writes]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if (!test_silent_operator())
+  {
+    failed++;
+  }
+
+  for (type = 0; type < 4; type++)
+  {
+    for (n = 0; n < traces; n++)
+    {
+      int last = test_trace(first + n, type, writes);
+      if (last >= 0)
+      {
+        printf("chip type %d, trace %u: mismatch after %d register writes\n", type, first + n, last);
+        failed++;
+      }
+    }
+  }
+
+  printf("%s\n", failed ? "FAILED" : "all traces match");
+  return failed ? 1 : 0;
+}
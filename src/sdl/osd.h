@@ -30,5 +30,6 @@
 #define MS_BIOS_EU  "./bios_E.sms"
 #define MS_BIOS_JP  "./bios_J.sms"
 #define GG_BIOS     "./bios.gg"
+#define CD_CACHE_DIR "./cdcache"
 
 #endif /* _OSD_H_ */
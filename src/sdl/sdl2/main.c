@@ -30,10 +30,28 @@ struct {
 
 /* sound */
 
+/* SDL callback buffer size, in stereo samples */
+#define SOUND_CALLBACK_SIZE 512
+
+/* ring buffer size, in stereo samples (must be a power of two) */
+#define SOUND_RING_SIZE 8192
+#define SOUND_RING_MASK (SOUND_RING_SIZE - 1)
+
+/* ring buffer fill level targeted by rate control, in stereo samples */
+#define SOUND_RING_TARGET (SOUND_CALLBACK_SIZE * 4)
+
+/* maximal time without samples being consumed by SDL audio callback before falling back to timer sync, in ms */
+#define SOUND_SYNC_TIMEOUT 50
+
+/* Single-producer (emulation loop) / single-consumer (SDL audio callback) ring buffer. */
+/* Read & write positions are free-running stereo sample counters, each one being only  */
+/* modified by its owner thread, so no lock is needed to exchange samples.              */
 struct {
-  char* current_pos;
-  char* buffer;
-  int current_emulated_samples;
+  short *buffer;
+  SDL_atomic_t head;
+  SDL_atomic_t tail;
+  int stalled;
+  unsigned int stalled_tail;
 } sdl_sound;
 
 
@@ -50,25 +68,42 @@ static short soundframe[SOUND_SAMPLES_SIZE];
 
 static void sdl_sound_callback(void *userdata, Uint8 *stream, int len)
 {
-  if(sdl_sound.current_emulated_samples < len) {
-    memset(stream, 0, len);
+  short *out = (short *)stream;
+  unsigned int head = (unsigned int)SDL_AtomicGet(&sdl_sound.head);
+  unsigned int tail = (unsigned int)SDL_AtomicGet(&sdl_sound.tail);
+  unsigned int size = len / (2 * sizeof(short));
+  unsigned int count = head - tail;
+
+  if (count > size)
+  {
+    count = size;
   }
-  else {
-    memcpy(stream, sdl_sound.buffer, len);
-    /* loop to compensate desync */
-    do {
-      sdl_sound.current_emulated_samples -= len;
-    } while(sdl_sound.current_emulated_samples > 2 * len);
-    memcpy(sdl_sound.buffer,
-           sdl_sound.current_pos - sdl_sound.current_emulated_samples,
-           sdl_sound.current_emulated_samples);
-    sdl_sound.current_pos = sdl_sound.buffer + sdl_sound.current_emulated_samples;
+
+  /* copy available samples (ring buffer might wrap once) */
+  while (count > 0)
+  {
+    unsigned int pos = tail & SOUND_RING_MASK;
+    unsigned int n = SOUND_RING_SIZE - pos;
+    if (n > count) n = count;
+    memcpy(out, &sdl_sound.buffer[pos * 2], n * 2 * sizeof(short));
+    out += n * 2;
+    tail += n;
+    count -= n;
+    size -= n;
+  }
+
+  /* release consumed samples */
+  SDL_AtomicSet(&sdl_sound.tail, (int)tail);
+
+  /* buffer underrun: output silence */
+  if (size > 0)
+  {
+    memset(out, 0, size * 2 * sizeof(short));
   }
 }
 
 static int sdl_sound_init()
 {
-  int n;
   SDL_AudioSpec as_desired;
 
   if(SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
@@ -76,56 +111,132 @@ static int sdl_sound_init()
     return 0;
   }
 
+  sdl_sound.buffer = (short *)calloc(SOUND_RING_SIZE * 2, sizeof(short));
+  if(!sdl_sound.buffer) {
+    SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", "Can't allocate audio buffer", sdl_video.window);
+    return 0;
+  }
+  SDL_AtomicSet(&sdl_sound.head, 0);
+  SDL_AtomicSet(&sdl_sound.tail, 0);
+  sdl_sound.stalled = 0;
+
   as_desired.freq     = SOUND_FREQUENCY;
   as_desired.format   = AUDIO_S16SYS;
   as_desired.channels = 2;
-  as_desired.samples  = SOUND_SAMPLES_SIZE;
+  as_desired.samples  = SOUND_CALLBACK_SIZE;
   as_desired.callback = sdl_sound_callback;
 
   if(SDL_OpenAudio(&as_desired, NULL) < 0) {
     SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", "SDL Audio open failed", sdl_video.window);
+    free(sdl_sound.buffer);
+    sdl_sound.buffer = NULL;
     return 0;
   }
 
-  sdl_sound.current_emulated_samples = 0;
-  n = SOUND_SAMPLES_SIZE * 2 * sizeof(short) * 20;
-  sdl_sound.buffer = (char*)malloc(n);
-  if(!sdl_sound.buffer) {
-    SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", "Can't allocate audio buffer", sdl_video.window);
-    return 0;
-  }
-  memset(sdl_sound.buffer, 0, n);
-  sdl_sound.current_pos = sdl_sound.buffer;
   return 1;
 }
 
+static int sdl_sound_fill()
+{
+  return (int)((unsigned int)SDL_AtomicGet(&sdl_sound.head) - (unsigned int)SDL_AtomicGet(&sdl_sound.tail));
+}
+
 static void sdl_sound_update(int enabled)
 {
-  int size = audio_update(soundframe) * 2;
+  int size;
 
-  if (enabled)
+  if (enabled && sdl_sound.buffer)
   {
-    int i;
-    short *out;
+    /* Dynamic rate control: output rate is slightly adjusted so that ring buffer */
+    /* fill level converges toward target, compensating for emulation & host      */
+    /* audio clocks drift without underruns or additional resampling stage.       */
+    double delta = (double)(SOUND_RING_TARGET - sdl_sound_fill()) / SOUND_RING_TARGET;
+    audio_set_rate_adjust(1.0 + AUDIO_RATE_ADJUST_MAX * delta);
+  }
+
+  size = audio_update(soundframe);
+
+  if (enabled && sdl_sound.buffer)
+  {
+    unsigned int head = (unsigned int)SDL_AtomicGet(&sdl_sound.head);
+    unsigned int tail = (unsigned int)SDL_AtomicGet(&sdl_sound.tail);
+    unsigned int count = SOUND_RING_SIZE - (head - tail);
+    short *in = soundframe;
 
-    SDL_LockAudio();
-    out = (short*)sdl_sound.current_pos;
-    for(i = 0; i < size; i++)
+    /* buffer overrun: drop excess samples */
+    if (count > (unsigned int)size)
     {
-      *out++ = soundframe[i];
+      count = size;
     }
-    sdl_sound.current_pos = (char*)out;
-    sdl_sound.current_emulated_samples += size * sizeof(short);
-    SDL_UnlockAudio();
+
+    /* copy samples (ring buffer might wrap once) */
+    while (count > 0)
+    {
+      unsigned int pos = head & SOUND_RING_MASK;
+      unsigned int n = SOUND_RING_SIZE - pos;
+      if (n > count) n = count;
+      memcpy(&sdl_sound.buffer[pos * 2], in, n * 2 * sizeof(short));
+      in += n * 2;
+      head += n;
+      count -= n;
+    }
+
+    /* publish written samples */
+    SDL_AtomicSet(&sdl_sound.head, (int)head);
   }
 }
 
+static int sdl_sound_sync()
+{
+  unsigned int tail;
+  Uint32 start;
+
+  if (!sdl_sound.buffer)
+    return 0;
+
+  tail = (unsigned int)SDL_AtomicGet(&sdl_sound.tail);
+
+  /* use timer sync until SDL audio callback consumes samples again */
+  if (sdl_sound.stalled)
+  {
+    if (tail == sdl_sound.stalled_tail)
+      return 0;
+    sdl_sound.stalled = 0;
+  }
+
+  /* wait until enough samples have been consumed by SDL audio callback */
+  start = SDL_GetTicks();
+  while (sdl_sound_fill() > SOUND_RING_TARGET)
+  {
+    unsigned int current = (unsigned int)SDL_AtomicGet(&sdl_sound.tail);
+    if (current != tail)
+    {
+      tail = current;
+      start = SDL_GetTicks();
+    }
+    else if ((SDL_GetTicks() - start) >= SOUND_SYNC_TIMEOUT)
+    {
+      /* audio device stalled (paused, lost, etc): fall back to timer sync */
+      sdl_sound.stalled = 1;
+      sdl_sound.stalled_tail = tail;
+      return 0;
+    }
+
+    SDL_Delay(1);
+  }
+
+  return 1;
+}
+
 static void sdl_sound_close()
 {
-  SDL_PauseAudio(1);
-  SDL_CloseAudio();
   if (sdl_sound.buffer)
+  {
+    SDL_PauseAudio(1);
+    SDL_CloseAudio();
     free(sdl_sound.buffer);
+    sdl_sound.buffer = NULL;
+  }
 }
 
 /* video */
@@ -854,7 +965,7 @@ int main (int argc, char **argv)
   /* reset system hardware */
   system_reset();
 
-  if(use_sound) SDL_PauseAudio(0);
+  if(sdl_sound.buffer) SDL_PauseAudio(0);
 
   /* 3 frames = 50 ms (60hz) or 60 ms (50hz) */
   if(sdl_sync.sem_sync)
@@ -893,9 +1004,19 @@ int main (int argc, char **argv)
     sdl_video_update();
     sdl_sound_update(use_sound);
 
-    if(!turbo_mode && sdl_sync.sem_sync && sdl_video.frames_rendered % 3 == 0)
+    if(!turbo_mode)
     {
-      SDL_SemWait(sdl_sync.sem_sync);
+      /* emulation is paced by audio output when sound is enabled */
+      if (use_sound && sdl_sound_sync())
+      {
+        /* discard pending timer events */
+        if (sdl_sync.sem_sync)
+          while (SDL_SemTryWait(sdl_sync.sem_sync) == 0);
+      }
+      else if (sdl_sync.sem_sync && sdl_video.frames_rendered % 3 == 0)
+      {
+        SDL_SemWait(sdl_sync.sem_sync);
+      }
     }
   }
 